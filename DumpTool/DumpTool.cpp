@@ -0,0 +1,268 @@
+#include <OpenCLMocker/DumpArchive.hpp>
+#include <OpenCLMocker/Hash.hpp>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace OpenCL;
+
+namespace
+{
+	// Read-only view of a whole archive.
+	class ArchiveView
+	{
+	public:
+		explicit ArchiveView(const std::string& path)
+		{
+#ifdef _WIN32
+			auto file = std::ifstream{path, std::ios::binary};
+			if (!file)
+				throw std::runtime_error{"Can't open " + path + "."};
+			contents.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+			data = contents.data();
+			size = contents.size();
+#else
+			const auto fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error{"Can't open " + path + "."};
+
+			struct stat st = {};
+			fstat(fd, &st);
+			size = static_cast<std::size_t>(st.st_size);
+
+			if (size != 0)
+			{
+				const auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapped == MAP_FAILED)
+				{
+					close(fd);
+					throw std::runtime_error{"Can't map " + path + "."};
+				}
+				data = static_cast<const char*>(mapped);
+			}
+
+			close(fd);
+#endif
+			ReadIndex();
+		}
+
+		~ArchiveView()
+		{
+#ifndef _WIN32
+			if (data != nullptr)
+				munmap(const_cast<char*>(data), size);
+#endif
+		}
+
+		const std::vector<Dump::ArchiveEntry>& GetEntries() const { return entries; }
+		bool HasFooter() const { return hasFooter; }
+
+		std::string_view GetOperation(const Dump::ArchiveEntry& entry) const { return {data + entry.operationOffset, entry.operationLength}; }
+		const char* GetData(const Dump::ArchiveEntry& entry) const { return data + entry.dataOffset; }
+
+	private:
+#ifdef _WIN32
+		std::vector<char> contents;
+#endif
+		const char* data = nullptr;
+		std::size_t size = 0;
+		std::vector<Dump::ArchiveEntry> entries;
+		bool hasFooter = false;
+
+		template <class TValue>
+		TValue Read(std::uint64_t offset) const
+		{
+			auto value = TValue{};
+			std::memcpy(&value, data + offset, sizeof(value));
+			return value;
+		}
+
+		// Whether [offset, offset + length) lies in [begin, end), without overflowing.
+		static bool IsWithin(std::uint64_t offset, std::uint64_t length, std::uint64_t begin, std::uint64_t end)
+		{
+			return offset >= begin && offset <= end && length <= end - offset;
+		}
+
+		void ReadIndex()
+		{
+			if (size < sizeof(Dump::ArchiveHeader) || Read<Dump::ArchiveHeader>(0).magic != Dump::ArchiveMagic)
+				throw std::runtime_error{"Not a dump archive."};
+
+			if (size >= sizeof(Dump::ArchiveHeader) + sizeof(Dump::ArchiveFooter))
+			{
+				const auto footer = Read<Dump::ArchiveFooter>(size - sizeof(Dump::ArchiveFooter));
+				const auto indexEnd = size - sizeof(Dump::ArchiveFooter);
+				const auto maxEntries = (indexEnd - sizeof(Dump::ArchiveHeader)) / sizeof(Dump::ArchiveEntry);
+
+				if (footer.magic == Dump::FooterMagic && footer.entryCount <= maxEntries && footer.indexOffset == indexEnd - footer.entryCount * sizeof(Dump::ArchiveEntry))
+				{
+					entries.resize(footer.entryCount);
+					std::memcpy(entries.data(), data + footer.indexOffset, footer.entryCount * sizeof(Dump::ArchiveEntry));
+
+					// Entries are written before the index, records pointing anywhere else are corrupted.
+					for (auto i = std::size_t{0}; i < entries.size(); ++i)
+					{
+						const auto& entry = entries[i];
+
+						if (!IsWithin(entry.operationOffset, entry.operationLength, sizeof(Dump::ArchiveHeader), footer.indexOffset) ||
+							!IsWithin(entry.dataOffset, entry.length, sizeof(Dump::ArchiveHeader), footer.indexOffset))
+							throw std::runtime_error{"Corrupted dump archive: index entry " + std::to_string(i) + " points outside of the entries."};
+					}
+
+					hasFooter = true;
+					return;
+				}
+			}
+
+			// No index, the process did not exit normally: walk the entries.
+			for (auto offset = std::uint64_t{sizeof(Dump::ArchiveHeader)}; offset + sizeof(Dump::ArchiveEntry) <= size;)
+			{
+				auto entry = Read<Dump::ArchiveEntry>(offset);
+				// Index records of a truncated index have the offsets set.
+				if (entry.magic != Dump::EntryMagic || entry.operationOffset != 0 || entry.dataOffset != 0)
+					break;
+
+				entry.operationOffset = offset + sizeof(entry);
+
+				// A truncated entry ends the walk, the lengths are checked before they are padded.
+				if (!IsWithin(entry.operationOffset, Dump::PadTo8(entry.operationLength), entry.operationOffset, size))
+					break;
+
+				entry.dataOffset = entry.operationOffset + Dump::PadTo8(entry.operationLength);
+
+				if (entry.length > size || !IsWithin(entry.dataOffset, Dump::PadTo8(entry.length), entry.dataOffset, size))
+					break;
+
+				entries.push_back(entry);
+				offset = entry.dataOffset + Dump::PadTo8(entry.length);
+			}
+		}
+	};
+
+	std::string GetFileName(const ArchiveView& archive, const Dump::ArchiveEntry& entry)
+	{
+		const auto range = entry.bufferOffset != 0 || entry.length != entry.bufferSize ? "@" + std::to_string(entry.bufferOffset) : std::string{};
+		return std::to_string(entry.globalSequence) + "_" + std::to_string(entry.bufferId) + "_" + std::to_string(entry.sequence) + "_" + std::string{archive.GetOperation(entry)} + range + ".buffer";
+	}
+
+	void WriteEntry(const ArchiveView& archive, const Dump::ArchiveEntry& entry, const std::filesystem::path& path)
+	{
+		auto file = std::ofstream{path, std::ios::binary};
+		file.write(archive.GetData(entry), static_cast<std::streamsize>(entry.length));
+
+		if (!file)
+			throw std::runtime_error{"Can't write " + path.string() + "."};
+	}
+
+	int List(const ArchiveView& archive)
+	{
+		std::cout << "#\tglobal\tbuffer\tseq\toffset\tlength\tsize\thash\toperation\n";
+
+		for (auto i = std::size_t{0}; i < archive.GetEntries().size(); ++i)
+		{
+			const auto& entry = archive.GetEntries()[i];
+			std::cout << i << '\t' << entry.globalSequence << '\t' << entry.bufferId << '\t' << entry.sequence << '\t'
+				<< entry.bufferOffset << '\t' << entry.length << '\t' << entry.bufferSize << '\t'
+				<< std::hex << entry.hash << std::dec << '\t' << archive.GetOperation(entry) << '\n';
+		}
+
+		if (!archive.HasFooter())
+			std::cerr << "Archive has no index, entries were recovered by scanning." << std::endl;
+
+		return 0;
+	}
+
+	int Verify(const ArchiveView& archive)
+	{
+		auto failed = 0;
+
+		for (auto i = std::size_t{0}; i < archive.GetEntries().size(); ++i)
+		{
+			const auto& entry = archive.GetEntries()[i];
+
+			if (Hash64(archive.GetData(entry), entry.length) != entry.hash)
+			{
+				std::cerr << "Entry " << i << " is corrupted." << std::endl;
+				++failed;
+			}
+		}
+
+		std::cout << archive.GetEntries().size() - failed << " of " << archive.GetEntries().size() << " entries are intact." << std::endl;
+		return failed == 0 ? 0 : 1;
+	}
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage:\n"
+			"  cldump list <archive>\n"
+			"  cldump verify <archive>\n"
+			"  cldump extract <archive> <entry> <output file>\n"
+			"  cldump extract-all <archive> <output directory>\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const auto args = std::vector<std::string>{argv + 1, argv + argc};
+
+	if (args.size() < 2)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	try
+	{
+		const auto& command = args[0];
+		const auto archive = ArchiveView{args[1]};
+
+		if (command == "list" && args.size() == 2)
+			return List(archive);
+
+		if (command == "verify" && args.size() == 2)
+			return Verify(archive);
+
+		if (command == "extract" && args.size() == 4)
+		{
+			const auto index = std::stoull(args[2]);
+			if (index >= archive.GetEntries().size())
+				throw std::runtime_error{"No entry " + args[2] + "."};
+
+			WriteEntry(archive, archive.GetEntries()[index], args[3]);
+			return 0;
+		}
+
+		if (command == "extract-all" && args.size() == 3)
+		{
+			const auto directory = std::filesystem::path{args[2]};
+			std::filesystem::create_directories(directory);
+
+			for (const auto& entry : archive.GetEntries())
+				WriteEntry(archive, entry, directory / GetFileName(archive, entry));
+			return 0;
+		}
+
+		PrintUsage();
+		return 2;
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of buffer dump archives written with the dumpFormat setting set to "archive".
+//
+// An archive starts with ArchiveHeader, followed by entries: ArchiveEntry, the operation name
+// and the dumped bytes, each padded to 8 bytes. The index, an array of ArchiveEntry with
+// absolute offsets, and ArchiveFooter are appended when the process exits. Archives of crashed
+// processes have no footer and can still be read by walking the entries.
+namespace OpenCL::Dump
+{
+	constexpr std::uint32_t ArchiveMagic = 0x4144434Cu; // "LCDA"
+	constexpr std::uint32_t EntryMagic = 0x4544434Cu; // "LCDE"
+	constexpr std::uint32_t FooterMagic = 0x4944434Cu; // "LCDI"
+	constexpr std::uint32_t ArchiveVersion = 1;
+
+	constexpr std::uint64_t PadTo8(std::uint64_t size) { return (size + 7) & ~std::uint64_t{7}; }
+
+	struct ArchiveHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+	};
+
+	struct ArchiveEntry
+	{
+		std::uint32_t magic;
+		std::uint32_t operationLength;
+		std::uint64_t bufferId;
+		// Dump number of the buffer and of the process.
+		std::uint64_t sequence;
+		std::uint64_t globalSequence;
+		// Dumped range of the buffer and the buffer size.
+		std::uint64_t bufferOffset;
+		std::uint64_t length;
+		std::uint64_t bufferSize;
+		// XXH64 of the dumped bytes.
+		std::uint64_t hash;
+		// Absolute in the index, 0 in the entry stream.
+		std::uint64_t operationOffset;
+		std::uint64_t dataOffset;
+	};
+
+	struct ArchiveFooter
+	{
+		std::uint64_t indexOffset;
+		std::uint64_t entryCount;
+		std::uint32_t magic;
+		std::uint32_t version;
+	};
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <CL/cl.h>
+
+/* Mocker specific queries. */
+
+/* clGetContextInfo: cl_mocker_memory_pool_statistics of the buffer storage cache. */
+#define CL_CONTEXT_MEMORY_POOL_STATISTICS_MOCKER 0x4F00
+
+typedef struct _cl_mocker_memory_pool_statistics
+{
+	cl_ulong hits;
+	cl_ulong misses;
+	cl_ulong cached_bytes;
+	cl_ulong cached_blocks;
+} cl_mocker_memory_pool_statistics;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <CL/cl.h>
+
+#include <cstddef>
+
+// Interface of kernel plugins: shared objects listed in the kernelPlugins setting which provide
+// CPU implementations for kernels. A plugin exports
+//
+//     extern "C" void clMockerRegisterKernels(OpenCL::Native::KernelRegistry& registry);
+//
+// and registers its functions by kernel name. clEnqueueNDRangeKernel then executes registered
+// kernels on the mocker worker threads, one work-group at a time.
+namespace OpenCL::Native
+{
+	struct KernelArg
+	{
+		// Bytes passed to clSetKernelArg, nullptr for __local arguments.
+		const void* value;
+		std::size_t size;
+		// Buffer contents for cl_mem arguments, work-group scratch memory for __local ones, nullptr otherwise.
+		void* memory;
+
+		template <class TValue>
+		const TValue& As() const { return *static_cast<const TValue*>(value); }
+
+		template <class TElement>
+		TElement* Memory() const { return static_cast<TElement*>(memory); }
+	};
+
+	struct WorkGroup
+	{
+		cl_uint dimensions;
+		std::size_t groupId[3];
+		std::size_t numGroups[3];
+		std::size_t globalOffset[3];
+		std::size_t globalSize[3];
+		// Size requested at enqueue and size of this group, which is smaller for the last group of a non-uniform range.
+		std::size_t enqueuedLocalSize[3];
+		std::size_t localSize[3];
+
+		// Global id of the first work item of the group.
+		std::size_t GetGlobalBase(cl_uint dimension) const { return globalOffset[dimension] + groupId[dimension] * enqueuedLocalSize[dimension]; }
+	};
+
+	// Executes every work item of the group.
+	using KernelFunction = void (*)(const KernelArg* args, std::size_t argCount, const WorkGroup& group);
+
+	class KernelRegistry
+	{
+	public:
+		virtual void Register(const char* name, KernelFunction function) = 0;
+
+	protected:
+		~KernelRegistry() = default;
+	};
+
+	using RegisterKernelsFunction = void (*)(KernelRegistry& registry);
+
+	constexpr const char* RegisterKernelsSymbol = "clMockerRegisterKernels";
+}
@@ -1,15 +1,22 @@
 ﻿#include <OpenCLMocker/Buffer.hpp>
 #include <OpenCLMocker/BufferType.hpp>
+#include <OpenCLMocker/BuildService.hpp>
+#include <OpenCLMocker/Config.hpp>
 #include <OpenCLMocker/Context.hpp>
 #include <OpenCLMocker/Device.hpp>
 #include <OpenCLMocker/Enums.hpp>
 #include <OpenCLMocker/Event.hpp>
 #include <OpenCLMocker/Exception.hpp>
+#include <OpenCLMocker/InternedText.hpp>
 #include <OpenCLMocker/Kernel.hpp>
 #include <OpenCLMocker/MemFlags.hpp>
+#include <OpenCLMocker/MemoryCopy.hpp>
 #include <OpenCLMocker/Platform.hpp>
 #include <OpenCLMocker/Program.hpp>
 #include <OpenCLMocker/Queue.hpp>
+#include <OpenCLMocker/Retained.hpp>
+
+#include <OpenCLMocker/Extensions.h>
 
 #include <CL/cl.h>
 
@@ -20,9 +27,12 @@
 #include <concepts>
 #include <iostream>
 #include <limits>
+#include <random>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <thread>
+#include <utility>
 
 using namespace OpenCL;
 
@@ -136,6 +146,29 @@ namespace
 		}
 	}
 
+	Region MakeRegion(const size_t* region)
+	{
+		if (region == nullptr || region[0] == 0 || region[1] == 0 || region[2] == 0)
+			throw Exception{CL_INVALID_VALUE, "Every dimension of the region should be non-zero."};
+
+		return {region[0], region[1], region[2]};
+	}
+
+	// Applies the default pitches of the rect commands and checks them against the region.
+	RectLayout MakeRectLayout(const size_t* origin, const Region& region, size_t rowPitch, size_t slicePitch)
+	{
+		if (origin == nullptr)
+			throw Exception{CL_INVALID_VALUE, "The origin of the region should not be nullptr."};
+
+		rowPitch = rowPitch != 0 ? rowPitch : region[0];
+		slicePitch = slicePitch != 0 ? slicePitch : region[1] * rowPitch;
+
+		if (rowPitch < region[0] || slicePitch < region[1] * rowPitch || slicePitch % rowPitch != 0)
+			throw Exception{CL_INVALID_VALUE, "Invalid row or slice pitch of the region."};
+
+		return {{origin[0], origin[1], origin[2]}, rowPitch, slicePitch};
+	}
+
 	Platform* GetPlatformByDeviceType(cl_device_type device_type)
 	{
 		for (auto& platform : Platform::Get())
@@ -147,17 +180,19 @@ namespace
 	}
 }
 
-template <class TRet>
-TRet Try(cl_int* errcode_ret, const Context* context, const TRet& defaultRet, const std::function<TRet()>& worker)
+// Only called on failure, so the successful calls never touch the callback.
+static void ReportError(const Context* context, const std::string& errorInfo, const std::vector<uint8_t>& miscData)
 {
-#if OPENCL_CATCH_EXCEPTIONS
-	const auto callback = (context != nullptr && context->errorCallback)
-		? context->errorCallback
-		: [](const std::string& errorInfo, const std::vector<uint8_t>& /*miscData*/)
-	{
+	if (context != nullptr && context->errorCallback)
+		context->errorCallback(errorInfo, miscData);
+	else
 		std::cerr << errorInfo << std::endl;
-	};
+}
 
+template <class TRet, class TWorker>
+TRet Try(cl_int* errcode_ret, const Context* context, const TRet& defaultRet, TWorker&& worker)
+{
+#if OPENCL_CATCH_EXCEPTIONS
 	try
 	{
 #endif
@@ -172,28 +207,28 @@ TRet Try(cl_int* errcode_ret, const Context* context, const TRet& defaultRet, co
 	}
 	catch (const Exception& ex)
 	{
-		callback("Exception: " + ex.GetDescription() + "(status: " + std::to_string(ex.GetStatus()) + ")", ex.GetMiscData());
+		ReportError(context, "Exception: " + ex.GetDescription() + "(status: " + std::to_string(ex.GetStatus()) + ")", ex.GetMiscData());
 		if (errcode_ret != nullptr)
 			*errcode_ret = ex.GetStatus();
 		return defaultRet;
 	}
 	catch (const std::bad_alloc& ex)
 	{
-		callback(std::string{"Allocation failure: "} + ex.what(), {});
+		ReportError(context, std::string{"Allocation failure: "} + ex.what(), {});
 		if (errcode_ret != nullptr)
 			*errcode_ret = CL_OUT_OF_HOST_MEMORY;
 		return defaultRet;
 	}
 	catch (const std::exception& ex)
 	{
-		callback(std::string{"Std exception: "} + ex.what(), {});
+		ReportError(context, std::string{"Std exception: "} + ex.what(), {});
 		if (errcode_ret != nullptr)
 			*errcode_ret = -1;
 		return defaultRet;
 	}
 	catch (...)
 	{
-		callback("Unknown error.", {});
+		ReportError(context, "Unknown error.", {});
 		if (errcode_ret != nullptr)
 			*errcode_ret = -1;
 		return defaultRet;
@@ -201,39 +236,51 @@ TRet Try(cl_int* errcode_ret, const Context* context, const TRet& defaultRet, co
 #endif
 }
 
-template <class TRet, class TCtxSource>
-	requires (!std::same_as<TCtxSource, std::nullptr_t> && !std::is_pointer_v<TCtxSource>)
-TRet Try(cl_int* errcode_ret, const TCtxSource& ctxSource, const TRet& defaultRet, const std::function<TRet()>& worker)
+// Invalid sources are left for the worker to report with the error code of their type.
+template <class TRet, class TCtxSource, class TWorker>
+	requires (!std::same_as<TCtxSource, Context>)
+TRet Try(cl_int* errcode_ret, const TCtxSource* ctxSource, const TRet& defaultRet, TWorker&& worker)
 {
-	if (!TCtxSource::Validate(&ctxSource) || !Context::Validate(ctxSource.ctx))
-	{
-		if (errcode_ret != nullptr)
-			*errcode_ret = CL_INVALID_CONTEXT;
-		return defaultRet;
-	}
-
-	return Try(errcode_ret, ctxSource.ctx, defaultRet, worker);
+	return Try(errcode_ret, ctxSource != nullptr ? ctxSource->ctx : nullptr, defaultRet, std::forward<TWorker>(worker));
 }
 
 class Void
 {
 };
 
-cl_int Try(const Context* context, const std::function<void()>& worker)
+template <class TWorker>
+cl_int Try(const Context* context, TWorker&& worker)
 {
 	cl_int ret = CL_SUCCESS;
 	Try<Void>(&ret, context, {}, [&worker]() { worker(); return Void{}; });
 	return ret;
 }
 
-template <class TCtxSource>
-cl_int Try(const TCtxSource& ctxSource, const std::function<void()>& worker)
+template <class TCtxSource, class TWorker>
+	requires (!std::same_as<TCtxSource, Context>)
+cl_int Try(const TCtxSource* ctxSource, TWorker&& worker)
 {
 	cl_int ret = CL_SUCCESS;
 	Try<Void>(&ret, ctxSource, {}, [&worker]() { worker(); return Void{}; });
 	return ret;
 }
 
+// Status code path for the hottest entry points: the worker returns expected errors instead of
+// throwing them, exceptions from deeper down are still caught. The description of an expected error
+// is only built when it is reported.
+template <class TCtxSource, class TWorker, class TDescriber>
+cl_int TryStatus(const TCtxSource* ctxSource, TWorker&& worker, TDescriber&& describe)
+{
+	const auto context = ctxSource != nullptr ? ctxSource->ctx : nullptr;
+	auto status = cl_int{CL_SUCCESS};
+	const auto ret = Try<cl_int>(&status, context, CL_SUCCESS, std::forward<TWorker>(worker));
+
+	if (ret != CL_SUCCESS)
+		ReportError(context, "Exception: " + describe(ret) + "(status: " + std::to_string(ret) + ")", {});
+
+	return status != CL_SUCCESS ? status : ret;
+}
+
 cl_int CL_API_CALL clGetPlatformIDs(cl_uint num_entries, cl_platform_id* platforms, cl_uint* num_platforms) CL_API_SUFFIX__VERSION_1_0
 {
 	return Try(nullptr, [&]()
@@ -391,44 +438,53 @@ cl_context CL_API_CALL clCreateContextFromType(const cl_context_properties* prop
 
 cl_int CL_API_CALL clRetainContext(cl_context context) CL_API_SUFFIX__VERSION_1_0
 {
-	return Try(&MapType(context), [&]()
+	return Try(MapType(context), [&]()
 		{
-			auto& ctx = MapType(context);
+			auto ctx = MapType(context);
 
-			if (!Context::Validate(&ctx))
+			if (!Context::Validate(ctx))
 				throw Exception{CL_INVALID_CONTEXT};
 
-			ctx.Retain(MapHandle(context));
+			ctx->Retain();
 		});
 }
 
 cl_int CL_API_CALL clGetContextInfo(cl_context context, cl_context_info param_name, size_t param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	return Try(&MapType(context), [&]()
+	return Try(MapType(context), [&]()
 		{
-			const auto& ctx = MapType(context);
+			const auto ctx = MapType(context);
 
-			if (!Context::Validate(&ctx))
+			if (!Context::Validate(ctx))
 				throw Exception{CL_INVALID_CONTEXT};
 
 			switch (param_name)
 			{
 			case CL_CONTEXT_REFERENCE_COUNT:
-				if (!FillProperty(static_cast<cl_uint>(ctx.GetReferenceCount(MapHandle(context))), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_REFERENCE_COUNT)"))
+				if (!FillProperty(static_cast<cl_uint>(ctx->GetReferenceCount()), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_REFERENCE_COUNT)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_CONTEXT_PLATFORM:
-				if (!FillProperty(MapType(ctx.platform), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_PLATFORM)"))
+				if (!FillProperty(MapType(ctx->platform), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_PLATFORM)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_CONTEXT_NUM_DEVICES:
-				if (!FillProperty(static_cast<cl_uint>(ctx.devices.size()), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_NUM_DEVICES)"))
+				if (!FillProperty(static_cast<cl_uint>(ctx->devices.size()), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_NUM_DEVICES)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_CONTEXT_DEVICES:
-				if (!FillArrayProperty(ctx.devices.data(), ctx.devices.size(), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_DEVICES)"))
+				if (!FillArrayProperty(ctx->devices.data(), ctx->devices.size(), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_DEVICES)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_CONTEXT_MEMORY_POOL_STATISTICS_MOCKER:
+			{
+				const auto statistics = ctx->memoryPool->GetStatistics();
+				// Same layout as cl_mocker_memory_pool_statistics.
+				const cl_ulong values[] = {statistics.hits, statistics.misses, statistics.cachedBytes, statistics.cachedBlocks};
+				if (!FillArrayProperty(values, std::size(values), param_value_size, param_value, param_value_size_ret, "clGetContextInfo(CL_CONTEXT_MEMORY_POOL_STATISTICS_MOCKER)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
+			}
 			default:
 				std::cerr << "Unknown device info: " << std::hex << param_name << std::endl;
 				throw Exception{CL_INVALID_VALUE};
@@ -503,17 +559,23 @@ cl_int CL_API_CALL clGetDeviceInfo(cl_device_id device, cl_device_info param_nam
 		});
 }
 
+void SetQueueProperties(Queue& queue, cl_command_queue_properties properties)
+{
+	if ((properties & ~(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE)) != 0)
+		throw Exception{CL_INVALID_QUEUE_PROPERTIES};
+
+	queue.outOfOrderExecutionMode = (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+	queue.profilingEnabled = (properties & CL_QUEUE_PROFILING_ENABLE) != 0;
+}
+
 void IterateOverQueueProperties(Queue& queue, const cl_queue_properties* properties)
 {
 	const auto propertyHandler = [&queue](cl_int name, const cl_queue_properties& value)
 	{
 		switch (name)
 		{
-		case CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE:
-			queue.outOfOrderExecutionMode = *reinterpret_cast<const cl_bool*>(value);
-			return;
-		case CL_QUEUE_PROFILING_ENABLE:
-			queue.profilingEnabled = *reinterpret_cast<const cl_bool*>(value);
+		case CL_QUEUE_PROPERTIES:
+			SetQueueProperties(queue, value);
 			return;
 		default:
 			throw Exception{CL_INVALID_VALUE};
@@ -524,47 +586,47 @@ void IterateOverQueueProperties(Queue& queue, const cl_queue_properties* propert
 	IterateOverProperties<cl_queue_properties>(properties, propertyHandler);
 }
 
-cl_command_queue CL_API_CALL clCreateCommandQueue(cl_context context, cl_device_id device, cl_command_queue_properties /* properties */, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_2_0
+cl_command_queue CL_API_CALL clCreateCommandQueue(cl_context context, cl_device_id device, cl_command_queue_properties properties, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_2_0
 {
-	return Try<cl_command_queue>(errcode_ret, &MapType(context), nullptr, [&]()
+	return Try<cl_command_queue>(errcode_ret, MapType(context), nullptr, [&]()
 		{
-			auto queue = Queue{};
+			auto ctx = MapType(context);
+			auto& device_ = MapType(device);
 
-			queue.ctx = &MapType(context);
-			queue.device = &MapType(device);
-
-			if (!Context::Validate(queue.ctx))
+			if (!Context::Validate(ctx))
 				throw Exception{CL_INVALID_CONTEXT};
-			if (!Device::Validate(queue.device))
+			if (!Device::Validate(&device_))
 				throw Exception{CL_INVALID_DEVICE};
 
+			auto queue = std::make_unique<Queue>(ctx, &device_);
+			SetQueueProperties(*queue, properties);
+
 			if (errcode_ret != nullptr)
 				*errcode_ret = CL_SUCCESS;
 
-			return MakeHandle(new Queue{std::move(queue)});
+			return MakeHandle(std::move(queue));
 		});
 }
 
 cl_command_queue CL_API_CALL clCreateCommandQueueWithProperties(cl_context context, cl_device_id device, const cl_queue_properties* properties, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_2_0
 {
-	return Try<cl_command_queue>(errcode_ret, &MapType(context), nullptr, [&]()
+	return Try<cl_command_queue>(errcode_ret, MapType(context), nullptr, [&]()
 		{
-			auto queue = Queue{};
-
-			queue.ctx = &MapType(context);
-			queue.device = &MapType(device);
+			auto ctx = MapType(context);
+			auto& device_ = MapType(device);
 
-			if (!Context::Validate(queue.ctx))
+			if (!Context::Validate(ctx))
 				throw Exception{CL_INVALID_CONTEXT};
-			if (!Device::Validate(queue.device))
+			if (!Device::Validate(&device_))
 				throw Exception{CL_INVALID_DEVICE};
 
-			IterateOverQueueProperties(queue, properties);
+			auto queue = std::make_unique<Queue>(ctx, &device_);
+			IterateOverQueueProperties(*queue, properties);
 
 			if (errcode_ret != nullptr)
 				*errcode_ret = CL_SUCCESS;
 
-			return MakeHandle(new Queue{std::move(queue)});
+			return MakeHandle(std::move(queue));
 		});
 }
 
@@ -572,12 +634,12 @@ cl_int CL_API_CALL clRetainCommandQueue(cl_command_queue command_queue) CL_API_S
 {
 	return Try(MapType(command_queue), [&]()
 		{
-			auto& queue = MapType(command_queue);
+			auto queue = MapType(command_queue);
 
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
 
-			queue.Retain(MapHandle(command_queue));
+			queue->Retain();
 		});
 }
 
@@ -585,10 +647,12 @@ cl_int CL_API_CALL clFlush(cl_command_queue command_queue) CL_API_SUFFIX__VERSIO
 {
 	return Try(MapType(command_queue), [&]()
 		{
-			auto& queue = MapType(command_queue);
+			auto queue = MapType(command_queue);
 
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
+
+			queue->Flush();
 		});
 }
 
@@ -596,20 +660,20 @@ cl_int CL_API_CALL clFinish(cl_command_queue command_queue) CL_API_SUFFIX__VERSI
 {
 	return Try(MapType(command_queue), [&]()
 		{
-			auto& queue = MapType(command_queue);
+			auto queue = MapType(command_queue);
 
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
 
-			queue.Wait();
+			queue->Wait();
 		});
 }
 
 cl_mem CL_API_CALL clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void* host_ptr, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	return Try<cl_mem>(errcode_ret, &MapType(context), nullptr, [&]()
+	return Try<cl_mem>(errcode_ret, MapType(context), nullptr, [&]()
 		{
-			return MakeHandle(new Buffer{&MapType(context), MemFlags{flags}, size, host_ptr});
+			return MakeHandle(new Buffer{MapType(context), MemFlags{flags}, size, host_ptr});
 		});
 }
 
@@ -617,25 +681,25 @@ cl_mem CL_API_CALL clCreateSubBuffer(cl_mem buffer, cl_mem_flags flags, cl_buffe
 {
 	return Try<cl_mem>(errcode_ret, MapType(buffer), nullptr, [&]()
 		{
-			auto& parent = MapType(buffer);
+			auto parent = MapType(buffer);
 
-			if (!Buffer::Validate(&parent))
+			if (!Buffer::Validate(parent))
 				throw Exception{CL_INVALID_MEM_OBJECT};
 
 			auto flags_ = MemFlags{flags};
 
 			if (!flags_.Validate() ||
-				parent.GetMemFlags().HasFlags(CL_MEM_READ_ONLY) && flags_.HasAnyFlags(CL_MEM_READ_WRITE | CL_MEM_WRITE_ONLY) ||
-				parent.GetMemFlags().HasFlags(CL_MEM_WRITE_ONLY) && flags_.HasAnyFlags(CL_MEM_READ_WRITE | CL_MEM_READ_ONLY) ||
-				parent.GetMemFlags().HasAnyFlags(CL_MEM_HOST_READ_ONLY | CL_MEM_HOST_NO_ACCESS) && flags_.HasFlags(CL_MEM_HOST_WRITE_ONLY) ||
-				parent.GetMemFlags().HasAnyFlags(CL_MEM_HOST_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS) && flags_.HasFlags(CL_MEM_HOST_READ_ONLY))
+				parent->GetMemFlags().HasFlags(CL_MEM_READ_ONLY) && flags_.HasAnyFlags(CL_MEM_READ_WRITE | CL_MEM_WRITE_ONLY) ||
+				parent->GetMemFlags().HasFlags(CL_MEM_WRITE_ONLY) && flags_.HasAnyFlags(CL_MEM_READ_WRITE | CL_MEM_READ_ONLY) ||
+				parent->GetMemFlags().HasAnyFlags(CL_MEM_HOST_READ_ONLY | CL_MEM_HOST_NO_ACCESS) && flags_.HasFlags(CL_MEM_HOST_WRITE_ONLY) ||
+				parent->GetMemFlags().HasAnyFlags(CL_MEM_HOST_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS) && flags_.HasFlags(CL_MEM_HOST_READ_ONLY))
 				throw Exception{CL_INVALID_VALUE};
 
 			if (flags_.GetKernelAccessFlags() == 0)
-				flags_ |= parent.GetMemFlags().GetKernelAccessFlags();
+				flags_ |= parent->GetMemFlags().GetKernelAccessFlags();
 
 			if (flags_.GetHostAccessFlags() == 0)
-				flags_ |= parent.GetMemFlags().GetHostAccessFlags();
+				flags_ |= parent->GetMemFlags().GetHostAccessFlags();
 
 			const auto buffer_create_type_ = BufferType{buffer_create_type};
 
@@ -643,7 +707,8 @@ cl_mem CL_API_CALL clCreateSubBuffer(cl_mem buffer, cl_mem_flags flags, cl_buffe
 				throw Exception{CL_INVALID_VALUE};
 
 			auto subBuffer = Buffer{flags_};
-			subBuffer.ctx = parent.ctx;
+			subBuffer.ctx = parent->ctx;
+			subBuffer.parent = Retained{*parent};
 
 			switch (buffer_create_type_.GetValue())
 			{
@@ -654,14 +719,14 @@ cl_mem CL_API_CALL clCreateSubBuffer(cl_mem buffer, cl_mem_flags flags, cl_buffe
 
 				const auto& region = *reinterpret_cast<const cl_buffer_region*>(buffer_create_info);
 
-				if (region.origin + region.size > parent.size)
+				if (region.origin + region.size > parent->size)
 					throw Exception{CL_INVALID_VALUE};
 
-				subBuffer.start = parent.start + region.origin;
+				subBuffer.start = parent->start + region.origin;
 				subBuffer.size = region.size;
 
-				if (parent.hostPtr != nullptr)
-					subBuffer.hostPtr = parent.hostPtr + region.origin;
+				if (parent->hostPtr != nullptr)
+					subBuffer.hostPtr = parent->hostPtr + region.origin;
 
 				break;
 			}
@@ -677,12 +742,58 @@ cl_int CL_API_CALL clRetainMemObject(cl_mem memobj) CL_API_SUFFIX__VERSION_1_0
 {
 	return Try(MapType(memobj), [&]()
 		{
-			auto& buffer = MapType(memobj);
+			auto buffer = MapType(memobj);
 
-			if (!Buffer::Validate(&buffer))
+			if (!Buffer::Validate(buffer))
 				throw Exception{CL_INVALID_MEM_OBJECT};
 
-			buffer.Retain(MapHandle(memobj));
+			buffer->Retain();
+		});
+}
+
+cl_int CL_API_CALL clGetMemObjectInfo(cl_mem memobj, cl_mem_info param_name, size_t param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_0
+{
+	const auto buffer = MapType(memobj);
+
+	return Try(buffer, [&]()
+		{
+			if (!Buffer::Validate(buffer))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+
+			switch (param_name)
+			{
+			case CL_MEM_TYPE:
+				if (!FillProperty(static_cast<cl_mem_object_type>(CL_MEM_OBJECT_BUFFER), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_TYPE)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_FLAGS:
+				if (!FillProperty(buffer->GetMemFlags().GetValue(), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_FLAGS)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_SIZE:
+				if (!FillProperty(buffer->size, param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_SIZE)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_HOST_PTR:
+				if (!FillProperty(static_cast<void*>(buffer->hostPtr), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_HOST_PTR)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_MAP_COUNT:
+				if (!FillProperty(buffer->GetMapCount(), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_MAP_COUNT)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_REFERENCE_COUNT:
+				if (!FillProperty(static_cast<cl_uint>(buffer->GetReferenceCount()), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_REFERENCE_COUNT)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_MEM_CONTEXT:
+				if (!FillProperty(MapType(buffer->ctx), param_value_size, param_value, param_value_size_ret, "clGetMemObjectInfo(CL_MEM_CONTEXT)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			default:
+				std::cerr << "Unknown mem object info: " << std::hex << param_name << std::endl;
+				throw Exception{CL_INVALID_VALUE};
+			}
 		});
 }
 
@@ -690,130 +801,366 @@ cl_int CL_API_CALL clEnqueueWriteBuffer(cl_command_queue command_queue, cl_mem b
 {
 	return Try(MapType(command_queue), [&]()
 		{
-			auto& queue = MapType(command_queue);
-			auto& buffer_ = MapType(buffer);
+			auto queue = MapType(command_queue);
+			auto buffer_ = MapType(buffer);
 
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
-			if (!Buffer::Validate(&buffer_))
+			if (!Buffer::Validate(buffer_))
 				throw Exception{CL_INVALID_MEM_OBJECT};
-			if (queue.ctx != buffer_.ctx)
+			if (queue->ctx != buffer_->ctx)
 				throw Exception{CL_INVALID_CONTEXT};
-			if (buffer_.size < offset + size || ptr == nullptr)
+			if (buffer_->size < offset + size || ptr == nullptr)
 				throw Exception{CL_INVALID_VALUE,
-				"Buffer size " + std::to_string(buffer_.size) + " is less than offset " + std::to_string(offset) + " + data size " + std::to_string(size) + "."};
+				"Buffer size " + std::to_string(buffer_->size) + " is less than offset " + std::to_string(offset) + " + data size " + std::to_string(size) + "."};
 			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
 				event_wait_list != nullptr && num_events_in_wait_list == 0)
 				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
-			if (buffer_.GetMemFlags().HasAnyFlags(CL_MEM_HOST_READ_ONLY | CL_MEM_HOST_NO_ACCESS))
+			if (buffer_->GetMemFlags().HasAnyFlags(CL_MEM_HOST_READ_ONLY | CL_MEM_HOST_NO_ACCESS))
 				throw Exception{CL_INVALID_OPERATION};
 
-			const Event* weakEvent;
-
-			{
-				auto mockEvent = std::make_unique<Event>(
-					std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
-					std::chrono::nanoseconds(1000 + rand() % 1000));
-
-				queue.RegisterEvent(mockEvent.get());
-
-				std::memcpy(buffer_.start + offset, ptr, size);
-				buffer_.Dump("write");
-
-				weakEvent = mockEvent.get();
-
-				if (ev != nullptr)
-					*ev = MakeHandle(std::move(mockEvent));
-			}
+			const auto mockEvent = queue->Enqueue(
+				CL_COMMAND_WRITE_BUFFER,
+				queue->device->performance.GetTransferDuration(TransferDirection::HostToDevice, size),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[buffer = Retained{*buffer_}, offset, size, ptr]()
+				{
+					buffer->Write(offset, size, ptr);
+					buffer->Dump("write", offset, size);
+				},
+				ev);
 
 			if (blocking_write)
-				weakEvent->Wait();
+				mockEvent->Wait();
 		});
 }
 
 cl_int CL_API_CALL clEnqueueReadBuffer(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_read, size_t offset, size_t  size, void* ptr, cl_uint  num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& queue = MapType(command_queue);
-	const auto& buffer_ = MapType(buffer);
+	auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(buffer);
 
 	return Try(queue, [&]()
 		{
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
-			if (!Buffer::Validate(&buffer_))
+			if (!Buffer::Validate(buffer_))
 				throw Exception{CL_INVALID_MEM_OBJECT};
-			if (queue.ctx != buffer_.ctx)
+			if (queue->ctx != buffer_->ctx)
 				throw Exception{CL_INVALID_CONTEXT};
 			// MIOpen relies on this size != 0:
-			if (size != 0 && (buffer_.size < offset + size || ptr == nullptr))
+			if (size != 0 && (buffer_->size < offset + size || ptr == nullptr))
 				throw Exception{CL_INVALID_VALUE};
 			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
 				event_wait_list != nullptr && num_events_in_wait_list == 0)
 				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
-			if (buffer_.GetMemFlags().HasAnyFlags(CL_MEM_HOST_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS))
+			if (buffer_->GetMemFlags().HasAnyFlags(CL_MEM_HOST_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS))
 				throw Exception{CL_INVALID_OPERATION};
 
-			const Event* weakEvent;
-
-			{
-				auto mockEvent = std::make_unique<Event>(
-					std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
-					std::chrono::nanoseconds(1000 + rand() % 1000));
-
-				queue.RegisterEvent(mockEvent.get());
-
-				weakEvent = mockEvent.get();
-
-				if (ev != nullptr)
-					*ev = MakeHandle(std::move(mockEvent));
-			}
+			const auto mockEvent = queue->Enqueue(
+				CL_COMMAND_READ_BUFFER,
+				queue->device->performance.GetTransferDuration(TransferDirection::DeviceToHost, size),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[buffer = Retained{*buffer_}, offset, size, ptr]() { buffer->Read(offset, size, ptr); },
+				ev);
 
 			if (blocking_read)
-				weakEvent->Wait();
+				mockEvent->Wait();
 		});
 }
 
 cl_int CL_API_CALL clEnqueueCopyBuffer(cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t size, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& queue = MapType(command_queue);
-	const auto& src = MapType(src_buffer);
-	auto& dst = MapType(dst_buffer);
+	auto queue = MapType(command_queue);
+	auto src = MapType(src_buffer);
+	auto dst = MapType(dst_buffer);
 
 	return Try(queue, [&]()
 		{
-			if (!Queue::Validate(&queue))
-				throw Exception{CL_INVALID_COMMAND_QUEUE, "clEnqueueCopyBuffer: Invalid command queue."};
-			if (!Buffer::Validate(&src))
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE, "clEnqueueCopyBuffer: Invalid command queue->"};
+			if (!Buffer::Validate(src))
 				throw Exception{CL_INVALID_MEM_OBJECT, "clEnqueueCopyBuffer: Invalid source buffer."};
-			if (!Buffer::Validate(&dst))
+			if (!Buffer::Validate(dst))
 				throw Exception{CL_INVALID_MEM_OBJECT, "clEnqueueCopyBuffer: Invalid destination buffer."};
-			if (queue.ctx != src.ctx)
+			if (queue->ctx != src->ctx)
 				throw Exception{CL_INVALID_CONTEXT, "clEnqueueCopyBuffer: Queue and source buffer must have the same context."};
-			if (queue.ctx != dst.ctx)
+			if (queue->ctx != dst->ctx)
 				throw Exception{CL_INVALID_CONTEXT, "clEnqueueCopyBuffer: Queue and destination buffer must have the same context."};
-			if (src.size < src_offset + size)
+			if (src->size < src_offset + size)
 				throw Exception{CL_INVALID_VALUE, "clEnqueueCopyBuffer: Source region is outside of the buffer."};
-			if (dst.size < dst_offset + size)
+			if (dst->size < dst_offset + size)
 				throw Exception{CL_INVALID_VALUE, "clEnqueueCopyBuffer: Destination region is outside of the buffer."};
 			if (event_wait_list == nullptr && num_events_in_wait_list != 0 ||
 				event_wait_list != nullptr && num_events_in_wait_list == 0 ||
-				!std::all_of(event_wait_list, event_wait_list + num_events_in_wait_list, [](auto event) { return Event::Validate(&MapType(event)); }))
+				!std::all_of(event_wait_list, event_wait_list + num_events_in_wait_list, [](auto event) { return Event::Validate(MapType(event)); }))
 				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
-			if (src.start + src_offset <= dst.start + dst_offset && dst.start + dst_offset <= src.start + src_offset + size + 1 ||
-				dst.start + src_offset <= src.start + dst_offset && src.start + dst_offset <= dst.start + src_offset + size + 1)
+			if (src->start + src_offset < dst->start + dst_offset + size && dst->start + dst_offset < src->start + src_offset + size)
 				throw Exception{CL_MEM_COPY_OVERLAP};
 
-			auto mockEvent = std::make_unique<Event>(
+			queue->Enqueue(
+				CL_COMMAND_COPY_BUFFER,
+				queue->device->performance.GetTransferDuration(TransferDirection::DeviceToDevice, size),
 				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
-				std::chrono::nanoseconds(1000 + rand() % 1000));
+				[src = Retained{*src}, dst = Retained{*dst}, src_offset, dst_offset, size]()
+				{
+					CopyBytes(dst->start + dst_offset, src->start + src_offset, size);
+					dst->Dump("copy-from-" + std::to_string(reinterpret_cast<std::ptrdiff_t>(src.Get())), dst_offset, size);
+				},
+				ev);
+		});
+}
+
+cl_int CL_API_CALL clEnqueueFillBuffer(cl_command_queue command_queue, cl_mem buffer, const void* pattern, size_t pattern_size, size_t offset, size_t size, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_2
+{
+	const auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(buffer);
 
-			queue.RegisterEvent(mockEvent.get());
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(buffer_))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != buffer_->ctx)
+				throw Exception{CL_INVALID_CONTEXT};
+			if (pattern == nullptr || pattern_size == 0 || pattern_size > 128 || (pattern_size & (pattern_size - 1)) != 0)
+				throw Exception{CL_INVALID_VALUE, "clEnqueueFillBuffer: pattern_size should be a power of two up to 128."};
+			if (offset % pattern_size != 0 || size % pattern_size != 0 || buffer_->size < offset + size)
+				throw Exception{CL_INVALID_VALUE, "clEnqueueFillBuffer: Invalid region."};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
 
-			std::memcpy(dst.start + dst_offset, src.start + src_offset, size);
-			dst.Dump("copy-from-" + std::to_string(reinterpret_cast<std::ptrdiff_t>(&src)));
+			const auto patternBytes = static_cast<const char*>(pattern);
 
-			if (ev != nullptr)
-				*ev = MakeHandle(std::move(mockEvent));
+			queue->Enqueue(
+				CL_COMMAND_FILL_BUFFER,
+				queue->device->performance.GetTransferDuration(TransferDirection::DeviceToDevice, size),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[buffer = Retained{*buffer_}, pattern = std::vector<char>{patternBytes, patternBytes + pattern_size}, offset, size]()
+				{
+					FillPattern(buffer->start + offset, size, pattern.data(), pattern.size());
+					buffer->Dump("fill", offset, size);
+				},
+				ev);
+		});
+}
+
+cl_int CL_API_CALL clEnqueueReadBufferRect(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_read, const size_t* buffer_offset, const size_t* host_offset, const size_t* region, size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, void* ptr, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(buffer);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(buffer_))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != buffer_->ctx)
+				throw Exception{CL_INVALID_CONTEXT};
+			if (ptr == nullptr)
+				throw Exception{CL_INVALID_VALUE};
+
+			const auto rect = MakeRegion(region);
+			const auto bufferLayout = MakeRectLayout(buffer_offset, rect, buffer_row_pitch, buffer_slice_pitch);
+			const auto hostLayout = MakeRectLayout(host_offset, rect, host_row_pitch, host_slice_pitch);
+
+			if (buffer_->size < bufferLayout.GetEnd(rect))
+				throw Exception{CL_INVALID_VALUE, "clEnqueueReadBufferRect: Region is outside of the buffer."};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+			if (buffer_->GetMemFlags().HasAnyFlags(CL_MEM_HOST_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS))
+				throw Exception{CL_INVALID_OPERATION};
+
+			const auto mockEvent = queue->Enqueue(
+				CL_COMMAND_READ_BUFFER_RECT,
+				queue->device->performance.GetTransferDuration(TransferDirection::DeviceToHost, rect[0] * rect[1] * rect[2]),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[buffer = Retained{*buffer_}, bufferLayout, hostLayout, rect, ptr]()
+				{
+					CopyRect(static_cast<char*>(ptr), hostLayout, buffer->start, bufferLayout, rect);
+				},
+				ev);
+
+			if (blocking_read)
+				mockEvent->Wait();
+		});
+}
+
+cl_int CL_API_CALL clEnqueueWriteBufferRect(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_write, const size_t* buffer_offset, const size_t* host_offset, const size_t* region, size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, const void* ptr, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(buffer);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(buffer_))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != buffer_->ctx)
+				throw Exception{CL_INVALID_CONTEXT};
+			if (ptr == nullptr)
+				throw Exception{CL_INVALID_VALUE};
+
+			const auto rect = MakeRegion(region);
+			const auto bufferLayout = MakeRectLayout(buffer_offset, rect, buffer_row_pitch, buffer_slice_pitch);
+			const auto hostLayout = MakeRectLayout(host_offset, rect, host_row_pitch, host_slice_pitch);
+
+			if (buffer_->size < bufferLayout.GetEnd(rect))
+				throw Exception{CL_INVALID_VALUE, "clEnqueueWriteBufferRect: Region is outside of the buffer."};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+			if (buffer_->GetMemFlags().HasAnyFlags(CL_MEM_HOST_READ_ONLY | CL_MEM_HOST_NO_ACCESS))
+				throw Exception{CL_INVALID_OPERATION};
+
+			const auto mockEvent = queue->Enqueue(
+				CL_COMMAND_WRITE_BUFFER_RECT,
+				queue->device->performance.GetTransferDuration(TransferDirection::HostToDevice, rect[0] * rect[1] * rect[2]),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[buffer = Retained{*buffer_}, bufferLayout, hostLayout, rect, ptr]()
+				{
+					CopyRect(buffer->start, bufferLayout, static_cast<const char*>(ptr), hostLayout, rect);
+					buffer->Dump("write-rect", bufferLayout.GetOffset(), bufferLayout.GetEnd(rect) - bufferLayout.GetOffset());
+				},
+				ev);
+
+			if (blocking_write)
+				mockEvent->Wait();
+		});
+}
+
+cl_int CL_API_CALL clEnqueueCopyBufferRect(cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer, const size_t* src_origin, const size_t* dst_origin, const size_t* region, size_t src_row_pitch, size_t src_slice_pitch, size_t dst_row_pitch, size_t dst_slice_pitch, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto queue = MapType(command_queue);
+	const auto src = MapType(src_buffer);
+	const auto dst = MapType(dst_buffer);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(src) || !Buffer::Validate(dst))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != src->ctx || queue->ctx != dst->ctx)
+				throw Exception{CL_INVALID_CONTEXT, "clEnqueueCopyBufferRect: Queue and buffers must have the same context."};
+
+			const auto rect = MakeRegion(region);
+			const auto srcLayout = MakeRectLayout(src_origin, rect, src_row_pitch, src_slice_pitch);
+			const auto dstLayout = MakeRectLayout(dst_origin, rect, dst_row_pitch, dst_slice_pitch);
+
+			if (src->size < srcLayout.GetEnd(rect))
+				throw Exception{CL_INVALID_VALUE, "clEnqueueCopyBufferRect: Source region is outside of the buffer."};
+			if (dst->size < dstLayout.GetEnd(rect))
+				throw Exception{CL_INVALID_VALUE, "clEnqueueCopyBufferRect: Destination region is outside of the buffer."};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+
+			if (src == dst)
+			{
+				if (srcLayout.rowPitch != dstLayout.rowPitch || srcLayout.slicePitch != dstLayout.slicePitch)
+					throw Exception{CL_INVALID_VALUE, "clEnqueueCopyBufferRect: Copies within a buffer should use the same pitches."};
+
+				const auto overlaps = [&](std::size_t d) { return srcLayout.origin[d] < dstLayout.origin[d] + rect[d] && dstLayout.origin[d] < srcLayout.origin[d] + rect[d]; };
+
+				if (overlaps(0) && overlaps(1) && overlaps(2))
+					throw Exception{CL_MEM_COPY_OVERLAP};
+			}
+
+			queue->Enqueue(
+				CL_COMMAND_COPY_BUFFER_RECT,
+				queue->device->performance.GetTransferDuration(TransferDirection::DeviceToDevice, rect[0] * rect[1] * rect[2]),
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				[src = Retained{*src}, dst = Retained{*dst}, srcLayout, dstLayout, rect]()
+				{
+					CopyRect(dst->start, dstLayout, src->start, srcLayout, rect);
+					dst->Dump("copy-rect-from-" + std::to_string(reinterpret_cast<std::ptrdiff_t>(src.Get())), dstLayout.GetOffset(), dstLayout.GetEnd(rect) - dstLayout.GetOffset());
+				},
+				ev);
+		});
+}
+
+void* CL_API_CALL clEnqueueMapBuffer(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_map, cl_map_flags map_flags, size_t offset, size_t size, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+	const auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(buffer);
+
+	return Try<void*>(errcode_ret, queue, nullptr, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(buffer_))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != buffer_->ctx)
+				throw Exception{CL_INVALID_CONTEXT};
+			if (size == 0 || buffer_->size < offset + size)
+				throw Exception{CL_INVALID_VALUE, "clEnqueueMapBuffer: Region is outside of the buffer."};
+			if ((map_flags & ~static_cast<cl_map_flags>(CL_MAP_READ | CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION)) != 0 ||
+				(map_flags & CL_MAP_WRITE_INVALIDATE_REGION) != 0 && (map_flags & (CL_MAP_READ | CL_MAP_WRITE)) != 0)
+				throw Exception{CL_INVALID_VALUE, "clEnqueueMapBuffer: Invalid map flags."};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+
+			const auto& memFlags = buffer_->GetMemFlags();
+
+			if (memFlags.HasFlags(CL_MEM_HOST_NO_ACCESS) ||
+				memFlags.HasFlags(CL_MEM_HOST_WRITE_ONLY) && (map_flags & CL_MAP_READ) != 0 ||
+				memFlags.HasFlags(CL_MEM_HOST_READ_ONLY) && (map_flags & (CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION)) != 0)
+				throw Exception{CL_INVALID_OPERATION};
+
+			// The region is not copied anywhere, so invalidating it does not need any work either.
+			const auto mockEvent = queue->Enqueue(
+				CL_COMMAND_MAP_BUFFER,
+				{},
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				{},
+				ev);
+
+			const auto ptr = buffer_->Map(offset, size, map_flags);
+
+			if (blocking_map)
+				mockEvent->Wait();
+
+			return ptr;
+		});
+}
+
+cl_int CL_API_CALL clEnqueueUnmapMemObject(cl_command_queue command_queue, cl_mem memobj, void* mapped_ptr, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_0
+{
+	const auto queue = MapType(command_queue);
+	const auto buffer_ = MapType(memobj);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (!Buffer::Validate(buffer_))
+				throw Exception{CL_INVALID_MEM_OBJECT};
+			if (queue->ctx != buffer_->ctx)
+				throw Exception{CL_INVALID_CONTEXT};
+			if (event_wait_list == nullptr && num_events_in_wait_list > 0 ||
+				event_wait_list != nullptr && num_events_in_wait_list == 0)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+
+			const auto mapping = buffer_->Unmap(mapped_ptr);
+			auto work = std::function<void()>{};
+
+			// The host wrote the storage directly, unmapping only has to dump what changed.
+			if ((mapping.flags & (CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION)) != 0)
+				work = [buffer = Retained{*buffer_}, mapping]() { buffer->Dump("unmap", mapping.offset, mapping.length); };
+
+			queue->Enqueue(
+				CL_COMMAND_UNMAP_MEM_OBJECT,
+				{},
+				std::vector<cl_event>{ event_wait_list, event_wait_list + num_events_in_wait_list },
+				std::move(work),
+				ev);
 		});
 }
 
@@ -821,18 +1168,31 @@ cl_int CL_API_CALL clGetCommandQueueInfo(cl_command_queue command_queue, cl_comm
 {
 	return Try(MapType(command_queue), [&]()
 		{
-			const auto& queue = MapType(command_queue);
+			const auto queue = MapType(command_queue);
+
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
 
 			switch (param_name)
 			{
 			case CL_QUEUE_CONTEXT:
-				if (!FillProperty(queue.ctx->handle, param_value_size, param_value, param_value_size_ret, "clGetCommandQueueInfo(CL_QUEUE_CONTEXT)"))
+				if (!FillProperty(MapType(queue->ctx), param_value_size, param_value, param_value_size_ret, "clGetCommandQueueInfo(CL_QUEUE_CONTEXT)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_QUEUE_DEVICE:
-				if (!FillProperty(MapType(queue.device), param_value_size, param_value, param_value_size_ret, "clGetCommandQueueInfo(CL_QUEUE_DEVICE)"))
+				if (!FillProperty(MapType(queue->device), param_value_size, param_value, param_value_size_ret, "clGetCommandQueueInfo(CL_QUEUE_DEVICE)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_QUEUE_PROPERTIES:
+			{
+				const auto properties = static_cast<cl_command_queue_properties>(
+					(queue->outOfOrderExecutionMode ? CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE : 0) |
+					(queue->profilingEnabled ? CL_QUEUE_PROFILING_ENABLE : 0));
+
+				if (!FillProperty(properties, param_value_size, param_value, param_value_size_ret, "clGetCommandQueueInfo(CL_QUEUE_PROPERTIES)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
+			}
 			default:
 				std::ostringstream ss;
 				ss << "Unknown device info: " << std::hex << param_name << std::endl;
@@ -843,38 +1203,50 @@ cl_int CL_API_CALL clGetCommandQueueInfo(cl_command_queue command_queue, cl_comm
 
 cl_program CL_API_CALL clCreateProgramWithSource(cl_context context, cl_uint count, const char** strings, const size_t* lengths, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	return Try<cl_program>(errcode_ret, &MapType(context), nullptr, [&]()
+	return Try<cl_program>(errcode_ret, MapType(context), nullptr, [&]()
 		{
-			if (!Context::Validate(&MapType(context)))
+			if (!Context::Validate(MapType(context)))
 				throw Exception(CL_INVALID_CONTEXT);
 			if (count == 0)
 				throw Exception(CL_INVALID_VALUE, "clCreateProgramWithSource: count should not be 0.");
 			if (strings == nullptr)
 				throw Exception(CL_INVALID_VALUE, "clCreateProgramWithSource: strings should not be nullptr.");
 
-			auto program = Program{};
-			program.ctx = &MapType(context);
+			auto program = std::make_unique<Program>();
+			program->ctx = MapType(context);
 
-			for (auto i = 0; i < count; ++i)
+			const auto getString = [&](cl_uint i)
 			{
-				if (lengths[i] == 0)
-					throw Exception(CL_INVALID_VALUE, "clCreateProgramWithSource: lengths[" + std::to_string(i) + "] should not be 0.");
 				if (strings[i] == nullptr)
 					throw Exception(CL_INVALID_VALUE, "clCreateProgramWithSource: strings[" + std::to_string(i) + "] should not be nullptr.");
-				program.sources.emplace_back(strings[i], lengths[i]);
+
+				// Strings without a length are null terminated.
+				return lengths == nullptr || lengths[i] == 0 ? std::string_view{strings[i]} : std::string_view{strings[i], lengths[i]};
+			};
+
+			if (count == 1)
+				program->source = InternedText::Get(getString(0));
+			else
+			{
+				auto source = std::string{};
+
+				for (auto i = cl_uint{0}; i < count; ++i)
+					source += getString(i);
+
+				program->source = InternedText::Get(std::move(source));
 			}
 
-			return MakeHandle(new Program{std::move(program)});
+			return MakeHandle(std::move(program));
 		});
 }
 
 cl_program CL_API_CALL clCreateProgramWithBinary(cl_context context, cl_uint num_devices, const cl_device_id* device_list, const size_t* lengths, const unsigned char** binaries, cl_int* /* binary_status */, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	return Try<cl_program>(errcode_ret, &MapType(context), nullptr, [&]()
+	return Try<cl_program>(errcode_ret, MapType(context), nullptr, [&]()
 		{
-			auto& ctx = MapType(context);
+			auto ctx = MapType(context);
 
-			if (!Context::Validate(&ctx))
+			if (!Context::Validate(ctx))
 				throw Exception(CL_INVALID_CONTEXT);
 			if (num_devices == 0)
 				throw Exception(CL_INVALID_VALUE, "clCreateProgramWithBinary: num_devices should not be 0.");
@@ -885,8 +1257,8 @@ cl_program CL_API_CALL clCreateProgramWithBinary(cl_context context, cl_uint num
 			if (binaries == nullptr)
 				throw Exception(CL_INVALID_VALUE, "clCreateProgramWithBinary: binaries should not be nullptr.");
 
-			auto program = Program{};
-			program.ctx = &ctx;
+			auto devices = std::vector<Device*>{};
+			auto texts = std::vector<InternedText>{};
 
 			for (auto i = 0; i < num_devices; ++i)
 			{
@@ -899,17 +1271,17 @@ cl_program CL_API_CALL clCreateProgramWithBinary(cl_context context, cl_uint num
 
 				if (!Device::Validate(device))
 					throw Exception{CL_INVALID_DEVICE, "clCreateProgramWithBinary: device_list[" + std::to_string(i) + "] is invalid."};
-				if (std::find(ctx.devices.begin(), ctx.devices.end(), device) == ctx.devices.end())
+				if (std::find(ctx->devices.begin(), ctx->devices.end(), device) == ctx->devices.end())
 					throw Exception{CL_INVALID_DEVICE, "clCreateProgramWithBinary: device_list[" + std::to_string(i) + "] is not associated with the passed context."};
 
-				program.devices.push_back(device);
-				program.binaries.emplace_back();
-				program.binaries.rbegin()->resize(lengths[i]);
-
-				std::memcpy(program.binaries.rbegin()->data(), binaries[i], lengths[i]);
+				devices.push_back(device);
+				texts.push_back(InternedText::Get(std::string_view{reinterpret_cast<const char*>(binaries[i]), lengths[i]}));
 			}
 
-			return MakeHandle(new Program{std::move(program)});
+			auto program = std::make_unique<Program>(std::move(devices), std::move(texts));
+			program->ctx = ctx;
+
+			return MakeHandle(std::move(program));
 		});
 }
 
@@ -917,27 +1289,62 @@ cl_int CL_API_CALL clRetainProgram(cl_program program) CL_API_SUFFIX__VERSION_1_
 {
 	return Try(MapType(program), [&]()
 		{
-			auto& program_ = MapType(program);
+			auto program_ = MapType(program);
 
-			if (!Program::Validate(&program_))
+			if (!Program::Validate(program_))
 				throw Exception(CL_INVALID_PROGRAM);
 
-			program_.Retain(MapHandle(program));
+			program_->Retain();
 		});
 }
 
+// Virtual time only moves the clocks of the devices the program is built for.
+static void SimulateBuild(const std::vector<Device*>& devices, bool cached)
+{
+	// rand() shares its state between threads.
+	thread_local auto random = std::minstd_rand{std::random_device{}()};
+	const auto compileDuration = std::chrono::duration_cast<DeviceClock::Duration>(std::chrono::milliseconds{std::uniform_int_distribution{10, 19}(random)});
+
+	const auto getDuration = [&](const Device& device) { return cached ? device.performance.GetCachedBuildDuration() : compileDuration; };
+
+	if (!Config::GetInstance().virtualTime)
+	{
+		auto duration = DeviceClock::Duration{};
+
+		for (auto device : devices)
+			duration = std::max(duration, getDuration(*device));
+
+		std::this_thread::sleep_for(duration);
+		return;
+	}
+
+	for (auto device : devices)
+		device->clock.SleepFor(getDuration(*device));
+}
+
+// Runs on a build thread for asynchronous builds, so failures end up in the build log instead of being thrown.
+static void BuildProgram(Program& program, const std::vector<Device*>& devices)
+{
+	try
+	{
+		auto executable = Program::Executable{};
+		SimulateBuild(devices, program.Compile(executable));
+		program.FinishBuild(std::move(executable));
+	}
+	catch (const std::exception& e)
+	{
+		program.FailBuild(e.what());
+	}
+}
+
 cl_int CL_API_CALL clBuildProgram(cl_program program, cl_uint num_devices, const cl_device_id* device_list, const char* options, void (CL_CALLBACK* pfn_notify)(cl_program /* program */, void* /* user_data */), void* user_data) CL_API_SUFFIX__VERSION_1_0
 {
 	return Try(MapType(program), [&]()
 		{
-			auto& program_ = MapType(program);
+			auto program_ = MapType(program);
 
-			if (!Program::Validate(&program_))
+			if (!Program::Validate(program_))
 				throw Exception(CL_INVALID_PROGRAM);
-			if (!program_.kernels.empty())
-				throw Exception(CL_INVALID_OPERATION, "clBuildProgram: attempt to build a program with attached kernels.");
-			if (program_.sources.empty() && program_.binaries.empty())
-				throw Exception(CL_INVALID_OPERATION, "clBuildProgram: attempt to build a program without sources or binaries.");
 			if (num_devices == 0)
 				throw Exception(CL_INVALID_VALUE, "clBuildProgram: num_devices should not be 0.");
 			if (device_list == nullptr)
@@ -945,8 +1352,7 @@ cl_int CL_API_CALL clBuildProgram(cl_program program, cl_uint num_devices, const
 			if (pfn_notify == nullptr && user_data != nullptr)
 				throw Exception(CL_INVALID_VALUE, "clBuildProgram: user_data should be nullptr, when pfn_notify is nullptr.");
 
-			auto& ctx = *program_.ctx;
-			const auto hadDevices = !program_.devices.empty();
+			auto requested = std::vector<Device*>{};
 
 			for (int i = 0; i < num_devices; ++i)
 			{
@@ -954,50 +1360,25 @@ cl_int CL_API_CALL clBuildProgram(cl_program program, cl_uint num_devices, const
 
 				if (!Device::Validate(device))
 					throw Exception{CL_INVALID_DEVICE, "clBuildProgram: device_list[" + std::to_string(i) + "] is invalid."};
-				if (hadDevices && std::find(program_.devices.begin(), program_.devices.end(), device) == ctx.devices.end())
-					throw Exception{CL_INVALID_DEVICE, "clBuildProgram: device_list[" + std::to_string(i) + "] is not associated with the passed program."};
 
-				if (!hadDevices)
-					program_.devices.push_back(device);
+				requested.push_back(device);
 			}
 
-			program_.buildStatuses.resize(num_devices);
-			program_.buildLogs.resize(num_devices);
-			program_.binaries.resize(num_devices);
-
-			for (int i = 0; i < num_devices; ++i)
-				program_.buildStatuses[i] = BuildStatus::InProgress;
-			program_.options = options != nullptr ? options : "";
-
-			const auto hadBinaries = !program_.binaries.empty();
+			auto devices = program_->StartBuild(requested, options != nullptr ? options : "");
+			auto& service = BuildService::GetInstance();
 
 			if (pfn_notify == nullptr)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds{10 + rand() % 10});
-				for (int i = 0; i < num_devices; ++i)
-				{
-					program_.buildStatuses[i] = BuildStatus::Success;
-					if (!hadBinaries)
-						program_.binaries[i] = {program_.sources[i].begin(), program_.sources[i].end()};
-				}
+				service.Run(devices, [&]() { BuildProgram(*program_, devices); });
+
+				if (program_->GetBuildStatus(0) == BuildStatus::Error)
+					throw Exception{CL_BUILD_PROGRAM_FAILURE, "clBuildProgram: " + program_->GetBuildLog(0)};
 				return;
 			}
 
-			std::thread([=]()
-				{
-					std::this_thread::sleep_for(std::chrono::milliseconds{10 + rand() % 10});
-
-					for (int i = 0; i < num_devices; ++i)
-					{
-						auto& program_ = MapType(program);
-
-						program_.buildStatuses[i] = BuildStatus::Success;
-						if (!hadBinaries)
-							program_.binaries[i] = {program_.sources[i].begin(), program_.sources[i].end()};
-					}
-
-					pfn_notify(program, user_data);
-				});
+			// The notification keeps the program alive as well, it runs after the build dropped its reference.
+			service.Submit(devices, [program_ = Retained{*program_}, devices]() { BuildProgram(*program_, devices); },
+				[program_ = Retained{*program_}, program, pfn_notify, user_data]() { pfn_notify(program, user_data); });
 		});
 }
 
@@ -1005,20 +1386,21 @@ cl_int CL_API_CALL clGetProgramBuildInfo(cl_program program, cl_device_id device
 {
 	return Try(MapType(program), [&]()
 		{
-			const auto& program_ = MapType(program);
+			const auto program_ = MapType(program);
 			const auto& device_ = &MapType(device);
 
-			if (!Program::Validate(&program_))
+			if (!Program::Validate(program_))
 				throw Exception{CL_INVALID_PROGRAM};
 			if (!Device::Validate(device_))
 				throw Exception{CL_INVALID_DEVICE};
 
-			const auto it = std::find(program_.devices.begin(), program_.devices.end(), device_);
+			const auto devices = program_->GetDevices();
+			const auto it = std::find(devices.begin(), devices.end(), device_);
 
-			if (it == program_.devices.end())
+			if (it == devices.end())
 				throw Exception{CL_INVALID_DEVICE};
 
-			const auto id = it - program_.devices.begin();
+			const auto id = static_cast<std::size_t>(it - devices.begin());
 
 			switch (param_name)
 			{
@@ -1026,10 +1408,7 @@ cl_int CL_API_CALL clGetProgramBuildInfo(cl_program program, cl_device_id device
 			{
 				const auto cl_status = [&]() -> cl_build_status
 				{
-					if (program_.buildStatuses.size() <= id)
-						return CL_BUILD_NONE;
-
-					switch (program_.buildStatuses[id])
+					switch (program_->GetBuildStatus(id))
 					{
 					default:
 					case BuildStatus::None: return CL_BUILD_NONE;
@@ -1044,16 +1423,11 @@ cl_int CL_API_CALL clGetProgramBuildInfo(cl_program program, cl_device_id device
 				return;
 			}
 			case CL_PROGRAM_BUILD_OPTIONS:
-				if (!FillStringProperty(program_.options, param_value_size, param_value, param_value_size_ret))
+				if (!FillStringProperty(program_->GetBuildOptions(), param_value_size, param_value, param_value_size_ret))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROGRAM_BUILD_LOG:
-				if (program_.buildStatuses.size() <= id)
-				{
-					if (!FillStringProperty("", param_value_size, param_value, param_value_size_ret))
-						throw Exception{CL_INVALID_VALUE};
-				}
-				else if (!FillStringProperty(program_.buildLogs[id], param_value_size, param_value, param_value_size_ret))
+				if (!FillStringProperty(program_->GetBuildLog(id), param_value_size, param_value, param_value_size_ret))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			default:
@@ -1066,31 +1440,31 @@ cl_int CL_API_CALL clGetProgramInfo(cl_program program, cl_program_info param_na
 {
 	return Try(MapType(program), [&]()
 		{
-			const auto& program_ = MapType(program);
+			const auto program_ = MapType(program);
 
-			if (!Program::Validate(&program_))
+			if (!Program::Validate(program_))
 				throw Exception{CL_INVALID_PROGRAM};
 
-			const auto& binaries = program_.binaries;
 
 			switch (param_name)
 			{
 			case CL_PROGRAM_REFERENCE_COUNT:
-				if (!FillProperty(program_.GetReferenceCount(MapHandle(program)), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_REFERENCE_COUNT)"))
+				if (!FillProperty(program_->GetReferenceCount(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_REFERENCE_COUNT)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROGRAM_CONTEXT:
-				if (!FillProperty(program_.ctx->handle, param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_CONTEXT)"))
+				if (!FillProperty(MapType(program_->ctx), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_CONTEXT)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROGRAM_NUM_DEVICES:
-				if (!FillProperty(program_.devices.size(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_NUM_DEVICES)"))
+				if (!FillProperty(program_->GetDevices().size(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_NUM_DEVICES)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROGRAM_DEVICES:
 			{
+				const auto programDevices = program_->GetDevices();
 				auto devices = std::vector<cl_device_id>{};
-				std::transform(program_.devices.begin(), program_.devices.end(), std::back_inserter(devices), [](auto&& device) { return MapType(device); });
+				std::transform(programDevices.begin(), programDevices.end(), std::back_inserter(devices), [](auto&& device) { return MapType(device); });
 
 				if (!FillArrayProperty(devices.data(), devices.size(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_DEVICES)"))
 					throw Exception{CL_INVALID_VALUE};
@@ -1098,8 +1472,9 @@ cl_int CL_API_CALL clGetProgramInfo(cl_program program, cl_program_info param_na
 			}
 			case CL_PROGRAM_BINARY_SIZES:
 			{
+				const auto binaries = program_->GetBinaries();
 				auto sizes = std::vector<std::size_t>{};
-				std::transform(binaries.begin(), binaries.end(), std::back_inserter(sizes), [](auto&& arr) { return arr.size(); });
+				std::transform(binaries.begin(), binaries.end(), std::back_inserter(sizes), [](auto&& binary) { return binary.GetSize(); });
 
 				if (!FillArrayProperty(sizes.data(), sizes.size(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_BINARY_SIZES)"))
 					throw Exception{CL_INVALID_VALUE};
@@ -1107,17 +1482,44 @@ cl_int CL_API_CALL clGetProgramInfo(cl_program program, cl_program_info param_na
 			}
 			case CL_PROGRAM_BINARIES:
 			{
+				const auto binaries = program_->GetBinaries();
+
 				if (ExtensiveLogging)
 					std::cerr << "CL Mocker(clGetProgramInfo(CL_PROGRAM_BINARIES)): Writing " << binaries.size() << " binaries to 0x" << std::ios::hex << reinterpret_cast<std::ptrdiff_t>(param_value) << std::ios::dec << "." << std::endl;
 
-				if (param_value_size / sizeof(std::size_t) != binaries.size() ||
-					param_value_size % sizeof(std::size_t) != 0)
+				if (param_value_size_ret != nullptr)
+					*param_value_size_ret = binaries.size() * sizeof(unsigned char*);
+
+				if (param_value == nullptr)
+					return;
+				if (param_value_size < binaries.size() * sizeof(unsigned char*))
 					throw Exception{CL_INVALID_VALUE};
 
-				const auto resultNum = param_value_size < sizeof(std::size_t);
-				char** results = reinterpret_cast<char**>(param_value);
-				for (auto i = 0; i < resultNum; ++i)
-					strncpy(results[i], binaries[i].data(), binaries[i].size());
+				// Binaries are arbitrary bytes, null entries are skipped.
+				const auto results = static_cast<unsigned char**>(param_value);
+				for (auto i = std::size_t{0}; i < binaries.size(); ++i)
+					if (results[i] != nullptr)
+						std::memcpy(results[i], binaries[i].GetData(), binaries[i].GetSize());
+				return;
+			}
+			case CL_PROGRAM_NUM_KERNELS:
+			{
+				const auto kernelTable = program_->GetKernelTable();
+
+				if (kernelTable == nullptr)
+					throw Exception{CL_INVALID_PROGRAM_EXECUTABLE};
+				if (!FillProperty(kernelTable->kernels.size(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_NUM_KERNELS)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			}
+			case CL_PROGRAM_KERNEL_NAMES:
+			{
+				const auto kernelTable = program_->GetKernelTable();
+
+				if (kernelTable == nullptr)
+					throw Exception{CL_INVALID_PROGRAM_EXECUTABLE};
+				if (!FillStringProperty(kernelTable->GetNames(), param_value_size, param_value, param_value_size_ret, "clGetProgramInfo(CL_PROGRAM_KERNEL_NAMES)"))
+					throw Exception{CL_INVALID_VALUE};
 				return;
 			}
 			default:
@@ -1127,26 +1529,83 @@ cl_int CL_API_CALL clGetProgramInfo(cl_program program, cl_program_info param_na
 		});
 }
 
+// Null when the table does not declare the kernel. Shares the ownership of the table.
+static std::shared_ptr<const KernelSignature> FindKernel(const std::shared_ptr<const KernelTable>& kernelTable, const std::string& name)
+{
+	const auto signature = kernelTable != nullptr ? kernelTable->Find(name) : nullptr;
+	return signature != nullptr ? std::shared_ptr<const KernelSignature>{kernelTable, signature} : nullptr;
+}
+
+// Takes over a kernel attached to the program with Program::AttachKernel.
+static cl_kernel CreateKernel(Program& program, const std::string& name, std::shared_ptr<const KernelSignature> signature)
+{
+	auto kernel = std::make_unique<Kernel>(std::move(signature));
+	kernel->ctx = program.ctx;
+	kernel->program = Retained{program};
+	kernel->name = name;
+
+	return MakeHandle(kernel.release());
+}
+
 cl_kernel CL_API_CALL clCreateKernel(cl_program program, const char* kernel_name, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_0
 {
 	return Try<cl_kernel>(errcode_ret, MapType(program), nullptr, [&]()
 		{
-			auto& program_ = MapType(program);
+			auto program_ = MapType(program);
 
-			if (!Program::Validate(&program_))
+			if (!Program::Validate(program_))
 				throw Exception{CL_INVALID_PROGRAM};
-			if (program_.binaries.empty() && std::all_of(program_.buildStatuses.begin(), program_.buildStatuses.end(), [](auto status) { return status == BuildStatus::Success; }))
-				throw Exception{CL_INVALID_BINARY};
 			if (kernel_name == nullptr)
 				throw Exception{CL_INVALID_VALUE};
 
-			auto kernel = std::make_unique<Kernel>();
-			kernel->ctx = program_.ctx;
-			kernel->program = &program_;
-			program_.kernels.push_back(kernel.get());
-			kernel->name = kernel_name;
+			const auto kernelTable = program_->AttachKernel();
+			auto signature = FindKernel(kernelTable, kernel_name);
+
+			// Sources without any kernel declaration are placeholders, they accept any name.
+			if (signature == nullptr && kernelTable != nullptr && !kernelTable->kernels.empty())
+			{
+				program_->DetachKernel();
+				throw Exception{CL_INVALID_KERNEL_NAME, "clCreateKernel: the program does not declare kernel " + std::string{kernel_name} + "."};
+			}
 
-			return MakeHandle(kernel.release());
+			return CreateKernel(*program_, kernel_name, std::move(signature));
+		});
+}
+
+cl_int CL_API_CALL clCreateKernelsInProgram(cl_program program, cl_uint num_kernels, cl_kernel* kernels, cl_uint* num_kernels_ret) CL_API_SUFFIX__VERSION_1_0
+{
+	return Try(MapType(program), [&]()
+		{
+			auto program_ = MapType(program);
+
+			if (!Program::Validate(program_))
+				throw Exception{CL_INVALID_PROGRAM};
+			if (program_->GetKernelTable() == nullptr)
+				throw Exception{CL_INVALID_PROGRAM_EXECUTABLE, "clCreateKernelsInProgram: the program is not built."};
+
+			// The attachment keeps a build from replacing the table while the kernels are created.
+			const auto kernelTable = program_->AttachKernel();
+			const auto detach = std::unique_ptr<Program, void (*)(Program*)>{program_, [](Program* program) { program->DetachKernel(); }};
+
+			if (kernelTable == nullptr)
+				throw Exception{CL_INVALID_PROGRAM_EXECUTABLE, "clCreateKernelsInProgram: the program is not built."};
+
+			const auto& declared = kernelTable->kernels;
+
+			if (kernels != nullptr && num_kernels < declared.size())
+				throw Exception{CL_INVALID_VALUE, "clCreateKernelsInProgram: num_kernels is less than the number of kernels in the program."};
+
+			if (kernels != nullptr)
+			{
+				for (auto i = std::size_t{0}; i < declared.size(); ++i)
+				{
+					program_->AttachKernel();
+					kernels[i] = CreateKernel(*program_, declared[i].name, FindKernel(kernelTable, declared[i].name));
+				}
+			}
+
+			if (num_kernels_ret != nullptr)
+				*num_kernels_ret = static_cast<cl_uint>(declared.size());
 		});
 }
 
@@ -1154,37 +1613,49 @@ cl_int CL_API_CALL clRetainKernel(cl_kernel kernel) CL_API_SUFFIX__VERSION_1_0
 {
 	return Try(MapType(kernel), [&]()
 		{
-			if (!Kernel::Validate(&MapType(kernel)))
+			if (!Kernel::Validate(MapType(kernel)))
 				throw Exception{CL_INVALID_KERNEL};
 
-			MapType(kernel).Retain(MapHandle(kernel));
+			MapType(kernel)->Retain();
 		});;
 }
 
 cl_int CL_API_CALL clGetKernelInfo(cl_kernel kernel, cl_kernel_info param_name, size_t param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	const auto& k = MapType(kernel);
+	const auto k = MapType(kernel);
 
 	return Try(k, [&]()
 		{
+			if (!Kernel::Validate(k))
+				throw Exception{CL_INVALID_KERNEL};
+
 			switch (param_name)
 			{
 			case CL_KERNEL_REFERENCE_COUNT:
-				if (!FillProperty(k.GetReferenceCount(MapHandle(kernel)), param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_REFERENCE_COUNT)"))
+				if (!FillProperty(k->GetReferenceCount(), param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_REFERENCE_COUNT)"))
 					throw Exception{CL_INVALID_ARG_SIZE};
 				return;
 			case CL_KERNEL_CONTEXT:
-				if (!FillProperty(k.ctx->handle, param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_CONTEXT)"))
+				if (!FillProperty(MapType(k->ctx), param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_CONTEXT)"))
 					throw Exception{CL_INVALID_ARG_SIZE};
 				return;
 			case CL_KERNEL_PROGRAM:
-				if (!FillProperty(k.program->handle, param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_PROGRAM)"))
+				if (!FillProperty(MapType(k->program.Get()), param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_PROGRAM)"))
 					throw Exception{CL_INVALID_ARG_SIZE};
 				return;
 			case CL_KERNEL_FUNCTION_NAME:
-				if (!FillStringProperty(k.name, param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_FUNCTION_NAME)"))
+				if (!FillStringProperty(k->name, param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_FUNCTION_NAME)"))
 					throw Exception{CL_INVALID_ARG_SIZE};
 				return;
+			case CL_KERNEL_NUM_ARGS:
+			{
+				// Without a declaration the arguments set so far are all the mocker knows of.
+				const auto count = k->signature != nullptr ? k->signature->args.size() : k->GetArgs().GetCount();
+
+				if (!FillProperty(static_cast<cl_uint>(count), param_value_size, param_value, param_value_size_ret, "clGetKernelInfo(CL_KERNEL_NUM_ARGS)"))
+					throw Exception{CL_INVALID_ARG_SIZE};
+				return;
+			}
 			default:
 				std::cerr << "Unknown device info: " << std::hex << param_name << std::endl;
 				throw Exception{CL_INVALID_ARG_SIZE};
@@ -1192,44 +1663,153 @@ cl_int CL_API_CALL clGetKernelInfo(cl_kernel kernel, cl_kernel_info param_name,
 		});
 }
 
-cl_int CL_API_CALL clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void* arg_value) CL_API_SUFFIX__VERSION_1_0
+cl_int CL_API_CALL clGetKernelArgInfo(cl_kernel kernel, cl_uint arg_index, cl_kernel_arg_info param_name, size_t param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_2
 {
-	return Try(MapType(kernel), [&]()
-		{
-			auto& kernel_ = MapType(kernel);
+	const auto k = MapType(kernel);
 
-			if (!Kernel::Validate(&kernel_))
+	return Try(k, [&]()
+		{
+			if (!Kernel::Validate(k))
 				throw Exception{CL_INVALID_KERNEL};
+			if (k->signature == nullptr || !k->program->HasKernelArgInfo())
+				throw Exception{CL_KERNEL_ARG_INFO_NOT_AVAILABLE, "clGetKernelArgInfo: the program has to be built from source with -cl-kernel-arg-info."};
+			if (arg_index >= k->signature->args.size())
+				throw Exception{CL_INVALID_ARG_INDEX};
+
+			const auto& arg = k->signature->args[arg_index];
 
-			kernel_.SetArg(arg_index, arg_size, arg_value);
+			switch (param_name)
+			{
+			case CL_KERNEL_ARG_ADDRESS_QUALIFIER:
+				if (!FillProperty(arg.addressQualifier, param_value_size, param_value, param_value_size_ret, "clGetKernelArgInfo(CL_KERNEL_ARG_ADDRESS_QUALIFIER)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_KERNEL_ARG_ACCESS_QUALIFIER:
+				if (!FillProperty(arg.accessQualifier, param_value_size, param_value, param_value_size_ret, "clGetKernelArgInfo(CL_KERNEL_ARG_ACCESS_QUALIFIER)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_KERNEL_ARG_TYPE_NAME:
+				if (!FillStringProperty(arg.typeName, param_value_size, param_value, param_value_size_ret, "clGetKernelArgInfo(CL_KERNEL_ARG_TYPE_NAME)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_KERNEL_ARG_TYPE_QUALIFIER:
+				if (!FillProperty(arg.typeQualifier, param_value_size, param_value, param_value_size_ret, "clGetKernelArgInfo(CL_KERNEL_ARG_TYPE_QUALIFIER)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_KERNEL_ARG_NAME:
+				if (!FillStringProperty(arg.name, param_value_size, param_value, param_value_size_ret, "clGetKernelArgInfo(CL_KERNEL_ARG_NAME)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			default:
+				throw Exception{CL_INVALID_VALUE};
+			}
 		});
 }
 
+cl_int CL_API_CALL clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void* arg_value) CL_API_SUFFIX__VERSION_1_0
+{
+	const auto kernel_ = MapType(kernel);
+
+	return TryStatus(kernel_, [&]()
+		{
+			if (!Kernel::Validate(kernel_))
+				return CL_INVALID_KERNEL;
+
+			return kernel_->SetArg(arg_index, arg_size, arg_value);
+		},
+		[&](cl_int status) { return status == CL_INVALID_KERNEL ? std::string{"clSetKernelArg: kernel is invalid."} : kernel_->DescribeArgError(status, arg_index, arg_size, arg_value); });
+}
+
 cl_int CL_API_CALL clEnqueueNDRangeKernel(cl_command_queue command_queue, cl_kernel kernel, cl_uint work_dim, const size_t* global_work_offset, const size_t* global_work_size, const size_t* local_work_size, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& queue = MapType(command_queue);
-	auto& kernel_ = MapType(kernel);
+	auto queue = MapType(command_queue);
+	auto kernel_ = MapType(kernel);
 
-	return Try(queue, [&]()
+	return TryStatus(queue, [&]()
 		{
-			if (!Queue::Validate(&queue))
-				throw Exception{CL_INVALID_COMMAND_QUEUE};
-			if (!Kernel::Validate(&kernel_))
-				throw Exception{CL_INVALID_KERNEL};
-			if (work_dim < 1)
-				throw Exception{CL_INVALID_WORK_DIMENSION};
+			if (!Queue::Validate(queue))
+				return CL_INVALID_COMMAND_QUEUE;
+			if (!Kernel::Validate(kernel_))
+				return CL_INVALID_KERNEL;
+			if (work_dim < 1 || work_dim > 3)
+				return CL_INVALID_WORK_DIMENSION;
+			if (global_work_size == nullptr)
+				return CL_INVALID_GLOBAL_WORK_SIZE;
+			// Arguments are sized from the signature, so a missing one is below the count.
+			if (kernel_->signature != nullptr && !kernel_->GetArgs().IsComplete())
+				return CL_INVALID_KERNEL_ARGS;
 			if (num_events_in_wait_list != 0 && event_wait_list == nullptr ||
 				num_events_in_wait_list == 0 && event_wait_list != nullptr)
-				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+				return CL_INVALID_EVENT_WAIT_LIST;
 
-			const auto gwo = std::vector<std::size_t>{global_work_offset, global_work_offset + work_dim};
+			const auto gwo = global_work_offset == nullptr
+				? std::vector<std::size_t>(work_dim, 0)
+				: std::vector<std::size_t>{global_work_offset, global_work_offset + work_dim};
 			const auto gwd = std::vector<std::size_t>{global_work_size, global_work_size + work_dim};
-			const auto lwd = std::vector<std::size_t>{local_work_size, local_work_size + work_dim};
+			const auto lwd = local_work_size == nullptr
+				? std::vector<std::size_t>{}
+				: std::vector<std::size_t>{local_work_size, local_work_size + work_dim};
 			const auto events = event_wait_list == nullptr
 				? std::vector<cl_event>{}
 				: std::vector<cl_event>{event_wait_list, event_wait_list + num_events_in_wait_list};
 
-			queue.EnqueueNDRangeKernel(kernel_, gwo, gwd, lwd, events, ev);
+			queue->EnqueueNDRangeKernel(*kernel_, gwo, gwd, lwd, events, ev);
+			return CL_SUCCESS;
+		},
+		[&](cl_int status) -> std::string
+		{
+			switch (status)
+			{
+			case CL_INVALID_COMMAND_QUEUE: return "clEnqueueNDRangeKernel: command_queue is invalid.";
+			case CL_INVALID_KERNEL: return "clEnqueueNDRangeKernel: kernel is invalid.";
+			case CL_INVALID_WORK_DIMENSION: return "clEnqueueNDRangeKernel: work_dim is " + std::to_string(work_dim) + ", it should be 1, 2 or 3.";
+			case CL_INVALID_GLOBAL_WORK_SIZE: return "clEnqueueNDRangeKernel: global_work_size should not be nullptr.";
+			case CL_INVALID_KERNEL_ARGS:
+			{
+				const auto& args = kernel_->GetArgs();
+				auto missing = std::string{};
+
+				for (auto i = std::size_t{0}; i < args.GetCount(); ++i)
+					if (!args.IsSet(i))
+						missing += (missing.empty() ? "" : ", ") + std::to_string(i);
+
+				return "clEnqueueNDRangeKernel: arguments " + missing + " of kernel " + kernel_->name + " are not set.";
+			}
+			case CL_INVALID_EVENT_WAIT_LIST: return "clEnqueueNDRangeKernel: num_events_in_wait_list and event_wait_list do not match.";
+			default: return "clEnqueueNDRangeKernel: the kernel could not be enqueued.";
+			}
+		});
+}
+
+cl_int CL_API_CALL clEnqueueMarkerWithWaitList(cl_command_queue command_queue, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_2
+{
+	auto queue = MapType(command_queue);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (num_events_in_wait_list != 0 && event_wait_list == nullptr ||
+				num_events_in_wait_list == 0 && event_wait_list != nullptr)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+
+			queue->Enqueue(CL_COMMAND_MARKER, {}, {event_wait_list, event_wait_list + num_events_in_wait_list}, {}, ev);
+		});
+}
+
+cl_int CL_API_CALL clEnqueueBarrierWithWaitList(cl_command_queue command_queue, cl_uint num_events_in_wait_list, const cl_event* event_wait_list, cl_event* ev) CL_API_SUFFIX__VERSION_1_2
+{
+	auto queue = MapType(command_queue);
+
+	return Try(queue, [&]()
+		{
+			if (!Queue::Validate(queue))
+				throw Exception{CL_INVALID_COMMAND_QUEUE};
+			if (num_events_in_wait_list != 0 && event_wait_list == nullptr ||
+				num_events_in_wait_list == 0 && event_wait_list != nullptr)
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+
+			queue->Enqueue(CL_COMMAND_BARRIER, {}, {event_wait_list, event_wait_list + num_events_in_wait_list}, {}, ev);
 		});
 }
 
@@ -1242,50 +1822,91 @@ cl_int CL_API_CALL clWaitForEvents(cl_uint num_events, const cl_event* event_lis
 
 	return Try(MapType(event_list[0]), [&]()
 		{
-			for (auto i = 0; i < num_events; ++i)
+			auto events = std::vector<const Event*>(num_events);
+
+			for (auto i = cl_uint{0}; i < num_events; ++i)
 			{
-				auto& mockEvent = MapType(event_list[i]);
+				events[i] = MapType(event_list[i]);
 
-				if (!Event::Validate(&mockEvent))
+				if (!Event::Validate(events[i]))
 					throw Exception{CL_INVALID_EVENT};
-				if (i > 0 && mockEvent.ctx != MapType(event_list[0]).ctx)
+				if (i > 0 && events[i]->ctx != events[0]->ctx)
 					throw Exception(CL_INVALID_CONTEXT, "clWaitForEvents: event_list should only contain events with the same context.");
+			}
 
-				if (!mockEvent.IsFinished())
-					mockEvent.Wait();
+			Event::WaitForAll(events);
+		});
+}
+
+cl_int CL_API_CALL clGetEventInfo(cl_event ev, cl_event_info param_name, size_t param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_0
+{
+	auto mockEvent = MapType(ev);
+
+	return Try(mockEvent, [&]()
+		{
+			if (!Event::Validate(mockEvent))
+				throw Exception{CL_INVALID_EVENT};
+
+			switch (param_name)
+			{
+			case CL_EVENT_COMMAND_QUEUE:
+				if (!FillProperty(MapType(mockEvent->queue), param_value_size, param_value, param_value_size_ret, "clGetEventInfo(CL_EVENT_COMMAND_QUEUE)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_EVENT_CONTEXT:
+				if (!FillProperty(MapType(mockEvent->ctx), param_value_size, param_value, param_value_size_ret, "clGetEventInfo(CL_EVENT_CONTEXT)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_EVENT_COMMAND_TYPE:
+				if (!FillProperty(mockEvent->GetType(), param_value_size, param_value, param_value_size_ret, "clGetEventInfo(CL_EVENT_COMMAND_TYPE)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_EVENT_COMMAND_EXECUTION_STATUS:
+				if (!FillProperty(mockEvent->GetStatus(), param_value_size, param_value, param_value_size_ret, "clGetEventInfo(CL_EVENT_COMMAND_EXECUTION_STATUS)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			case CL_EVENT_REFERENCE_COUNT:
+				if (!FillProperty(static_cast<cl_uint>(mockEvent->GetReferenceCount()), param_value_size, param_value, param_value_size_ret, "clGetEventInfo(CL_EVENT_REFERENCE_COUNT)"))
+					throw Exception{CL_INVALID_VALUE};
+				return;
+			default:
+				std::cerr << "Unknown event info: " << std::hex << param_name << std::endl;
+				throw Exception{CL_INVALID_VALUE};
 			}
 		});
 }
 
 cl_int CL_API_CALL clGetEventProfilingInfo(cl_event ev, cl_profiling_info  param_name, size_t  param_value_size, void* param_value, size_t* param_value_size_ret) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& mockEvent = MapType(ev);
+	auto mockEvent = MapType(ev);
 
 	return Try(mockEvent, [&]()
 		{
-			if (!Event::Validate(&mockEvent))
+			if (!Event::Validate(mockEvent))
 				throw Exception{CL_INVALID_EVENT};
+			if (mockEvent->IsUser() || !mockEvent->IsFinished())
+				throw Exception{CL_PROFILING_INFO_NOT_AVAILABLE};
 
 			switch (param_name)
 			{
 			case CL_PROFILING_COMMAND_QUEUED:
-				if (!FillProperty<cl_ulong>(mockEvent.GetQueued().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_QUEUED)"))
+				if (!FillProperty<cl_ulong>(mockEvent->GetQueued().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_QUEUED)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROFILING_COMMAND_SUBMIT:
-				if (!FillProperty<cl_ulong>(mockEvent.GetSubmitted().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_SUBMIT)"))
+				if (!FillProperty<cl_ulong>(mockEvent->GetSubmitted().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_SUBMIT)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROFILING_COMMAND_START:
-				if (!FillProperty<cl_ulong>(mockEvent.GetStart().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_START)"))
+				if (!FillProperty<cl_ulong>(mockEvent->GetStart().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_START)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROFILING_COMMAND_END:
-				if (!FillProperty<cl_ulong>(mockEvent.GetEnd().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_END)"))
+				if (!FillProperty<cl_ulong>(mockEvent->GetEnd().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_END)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			case CL_PROFILING_COMMAND_COMPLETE:
-				if (!FillProperty<cl_ulong>(mockEvent.GetComplete().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_COMPLETE)"))
+				if (!FillProperty<cl_ulong>(mockEvent->GetComplete().time_since_epoch().count(), param_value_size, param_value, param_value_size_ret, "clGetEventProfilingInfo(CL_PROFILING_COMMAND_COMPLETE)"))
 					throw Exception{CL_INVALID_VALUE};
 				return;
 			default:
@@ -1295,86 +1916,125 @@ cl_int CL_API_CALL clGetEventProfilingInfo(cl_event ev, cl_profiling_info  param
 		});
 }
 
+cl_event CL_API_CALL clCreateUserEvent(cl_context context, cl_int* errcode_ret) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto ctx = MapType(context);
+
+	return Try(errcode_ret, ctx, cl_event{}, [&]()
+		{
+			if (!Context::Validate(ctx))
+				throw Exception{CL_INVALID_CONTEXT};
+
+			return MakeHandle(std::make_unique<Event>(*ctx));
+		});
+}
+
+cl_int CL_API_CALL clSetUserEventStatus(cl_event ev, cl_int execution_status) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto mockEvent = MapType(ev);
+
+	return Try(mockEvent, [&]()
+		{
+			if (!Event::Validate(mockEvent) || !mockEvent->IsUser())
+				throw Exception{CL_INVALID_EVENT};
+			if (execution_status > CL_COMPLETE)
+				throw Exception{CL_INVALID_VALUE, "clSetUserEventStatus: execution_status should be CL_COMPLETE or negative."};
+			if (mockEvent->IsFinished())
+				throw Exception{CL_INVALID_OPERATION, "clSetUserEventStatus: the status of the event is already set."};
+
+			mockEvent->SetUserStatus(execution_status);
+		});
+}
+
+cl_int CL_API_CALL clSetEventCallback(cl_event ev, cl_int command_exec_callback_type, void (CL_CALLBACK* pfn_notify)(cl_event, cl_int, void*), void* user_data) CL_API_SUFFIX__VERSION_1_1
+{
+	const auto mockEvent = MapType(ev);
+
+	return Try(mockEvent, [&]()
+		{
+			if (!Event::Validate(mockEvent))
+				throw Exception{CL_INVALID_EVENT};
+			if (pfn_notify == nullptr)
+				throw Exception{CL_INVALID_VALUE, "clSetEventCallback: pfn_notify should not be nullptr."};
+			if (command_exec_callback_type != CL_SUBMITTED && command_exec_callback_type != CL_RUNNING && command_exec_callback_type != CL_COMPLETE)
+				throw Exception{CL_INVALID_VALUE, "clSetEventCallback: unknown command_exec_callback_type."};
+
+			mockEvent->AddCallback(command_exec_callback_type, pfn_notify, user_data);
+		});
+}
+
 cl_int CL_API_CALL clReleaseMemObject(cl_mem memobj) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& mem = MapType(memobj);
+	auto mem = MapType(memobj);
 	return Try(mem, [&]()
 		{
-			if (!Buffer::Validate(&mem))
+			if (!Buffer::Validate(mem))
 				throw Exception{CL_INVALID_MEM_OBJECT};
 
-			auto& handle = MapHandle(memobj);
-			if (mem.Release(handle))
-				delete &handle;
+			mem->Release();
 		});
 }
 
 cl_int CL_API_CALL clReleaseKernel(cl_kernel kernel) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& k = MapType(kernel);
+	auto k = MapType(kernel);
 	return Try(k, [&]()
 		{
-			if (!Kernel::Validate(&k))
+			if (!Kernel::Validate(k))
 				throw Exception{CL_INVALID_KERNEL};
 
-			auto& handle = MapHandle(kernel);
-			if (k.Release(handle))
-				delete &handle;
+			k->Release();
 		});
 }
 
 cl_int CL_API_CALL clReleaseProgram(cl_program program) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& p = MapType(program);
+	auto p = MapType(program);
 	return Try(p, [&]()
 		{
-			if (!Program::Validate(&p))
+			if (!Program::Validate(p))
 				throw Exception{CL_INVALID_PROGRAM};
 
-			auto& handle = MapHandle(program);
-			if (p.Release(handle))
-				delete& handle;
+			p->Release();
 		});
 }
 
 cl_int CL_API_CALL clReleaseCommandQueue(cl_command_queue command_queue) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& queue = MapType(command_queue);
+	auto queue = MapType(command_queue);
 	return Try(queue, [&]()
 		{
-			if (!Queue::Validate(&queue))
+			if (!Queue::Validate(queue))
 				throw Exception{CL_INVALID_COMMAND_QUEUE};
 
-			auto& handle = MapHandle(command_queue);
-			if (queue.Release(handle))
-				delete& handle;
+			// Releasing flushes implicitly, the queue lives on until the flushed commands are complete.
+			queue->Flush();
+			queue->Release();
 		});
 }
 
 cl_int CL_API_CALL clReleaseContext(cl_context context) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& ctx = MapType(context);
-	return Try(&ctx, [&]()
+	auto ctx = MapType(context);
+	return Try(ctx, [&]()
 		{
-			if (!Context::Validate(&ctx))
+			if (!Context::Validate(ctx))
 				throw Exception{CL_INVALID_CONTEXT};
 
-			auto& handle = MapHandle(context);
-			if (ctx.Release(handle))
-				delete& handle;
+			ctx->Release();
 		});
 }
 
 cl_int CL_API_CALL clReleaseEvent(cl_event ev) CL_API_SUFFIX__VERSION_1_0
 {
-	auto& event = MapType(ev);
-	return Try(event, [&]()
+	const auto event = MapType(ev);
+	return TryStatus(event, [&]()
 		{
-			if (!Event::Validate(&event))
-				throw Exception {CL_INVALID_EVENT};
+			if (!Event::Validate(event))
+				return CL_INVALID_EVENT;
 
-			auto& handle = MapHandle(ev);
-			if (event.Release(handle))
-				delete& handle;
-		});
+			event->Release();
+			return CL_SUCCESS;
+		},
+		[](cl_int) { return std::string{"clReleaseEvent: event is invalid."}; });
 }
\ No newline at end of file
@@ -2,12 +2,18 @@
 
 #include <OpenCLMocker/Config.hpp>
 #include <OpenCLMocker/Context.hpp>
+#include <OpenCLMocker/DumpWriter.hpp>
 #include <OpenCLMocker/Exception.hpp>
+#include <OpenCLMocker/Hash.hpp>
+#include <OpenCLMocker/MemoryCopy.hpp>
 
+#include <algorithm>
 #include <atomic>
-#include <fstream>
 #include <string>
+#include <sstream>
 #include <cstring>
+#include <iterator>
+#include <mutex>
 
 namespace OpenCL
 {
@@ -51,18 +57,101 @@ namespace OpenCL
 		}
 		else
 		{
-			gpuMemory = std::make_unique<char[]>(size);
-			start = gpuMemory.get();
+			memoryPool = ctx->memoryPool;
+			gpuMemory = memoryPool->Acquire(size);
+			start = gpuMemory.Get();
 
 			if (flags.HasFlags(CL_MEM_COPY_HOST_PTR))
-				std::memcpy(start, hostPtr, size);
+				CopyBytes(start, hostPtr, size);
 		}
 
 		if (flags.HasAnyFlags(CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR))
 			Dump("create");
 	}
 
+	Buffer::Buffer(Buffer&& other)
+		: Object(std::move(other))
+		, gpuMemory(std::move(other.gpuMemory))
+		, memoryPool(std::move(other.memoryPool))
+		, hostMemory(std::move(other.hostMemory))
+		, parent(std::move(other.parent))
+		, ctx(other.ctx)
+		, start(other.start)
+		, hostPtr(other.hostPtr)
+		, size(other.size)
+		, flags(std::move(other.flags))
+		, dumpIndex(other.dumpIndex.load())
+		, mappings(std::move(other.mappings))
+		, dumpedRanges(std::move(other.dumpedRanges))
+	{
+	}
+
+	Buffer::~Buffer()
+	{
+		if (memoryPool != nullptr)
+			memoryPool->Recycle(std::move(gpuMemory));
+	}
+
+	Retained<Buffer> Buffer::FindByValue(const void* value, std::size_t size)
+	{
+		if (value == nullptr || size != sizeof(cl_mem))
+			return {};
+
+		auto mem = cl_mem{};
+		std::memcpy(&mem, value, sizeof(mem));
+
+		const auto buffer = MapType(mem);
+		return buffer != nullptr ? Retained{*buffer} : Retained<Buffer>{};
+	}
+
+	void Buffer::Read(std::size_t offset, std::size_t length, void* ptr) const
+	{
+		if (ptr != start + offset)
+			CopyBytes(ptr, start + offset, length);
+	}
+
+	void Buffer::Write(std::size_t offset, std::size_t length, const void* ptr)
+	{
+		if (ptr != start + offset)
+			CopyBytes(start + offset, ptr, length);
+	}
+
+	void* Buffer::Map(std::size_t offset, std::size_t length, cl_map_flags mapFlags)
+	{
+		const auto ptr = start + offset;
+
+		auto lock = std::lock_guard{mapMutex};
+		mappings.push_back({ptr, offset, length, mapFlags});
+		return ptr;
+	}
+
+	Buffer::Mapping Buffer::Unmap(const void* ptr)
+	{
+		auto lock = std::lock_guard{mapMutex};
+
+		// The same region can be mapped several times, the latest mapping is unmapped first.
+		const auto found = std::find_if(mappings.rbegin(), mappings.rend(), [&](const Mapping& mapping) { return mapping.ptr == ptr; });
+
+		if (found == mappings.rend())
+			throw Exception{CL_INVALID_VALUE, "The pointer is not mapped from the buffer."};
+
+		const auto mapping = *found;
+		mappings.erase(std::next(found).base());
+		return mapping;
+	}
+
+	cl_uint Buffer::GetMapCount() const
+	{
+		auto lock = std::lock_guard{mapMutex};
+		return static_cast<cl_uint>(mappings.size());
+	}
+
 	void Buffer::Dump(const std::string& operation)
+	{
+		Dump(operation, 0, size);
+	}
+
+	void Buffer::Dump(const std::string& operation, std::size_t offset, std::size_t length)
 	{
 		const auto& root = Config::GetInstance().dumpBuffersRoot;
 		const auto& filter = Config::GetInstance().dumpBuffersOpFilter;
@@ -73,17 +162,47 @@ namespace OpenCL
 		if (!root.has_value() || !filter.empty() && std::find(filter.begin(), filter.end(), opId) == filter.end())
 			return;
 
+		const auto hash = Hash64(start + offset, length);
+
+		{
+			auto lock = std::lock_guard{dumpMutex};
+
+			if (!UpdateDumpedRanges(offset, length, hash))
+				return;
+		}
+
 		static std::atomic<std::size_t> globalIndex = 0;
-		const auto curGlobalIndex = globalIndex++;
-		const auto index = dumpIndex++;
-		const auto thisStr = std::to_string(reinterpret_cast<std::ptrdiff_t>(this));
-		const auto filename = globalIndex + "_" + thisStr + "_" + std::to_string(index) + "_" + operation + ".buffer";
-		const auto path = *root / filename;
 
-		std::filesystem::create_directories(*root);
+		auto info = DumpInfo{};
+		info.operation = operation;
+		info.bufferId = reinterpret_cast<std::uintptr_t>(this);
+		info.sequence = dumpIndex++;
+		info.globalSequence = globalIndex++;
+		info.bufferOffset = offset;
+		info.bufferSize = size;
+		info.hash = hash;
+
+		DumpWriter::GetInstance().Submit(std::move(info), start + offset, length);
+	}
+
+	bool Buffer::UpdateDumpedRanges(std::size_t offset, std::size_t length, std::uint64_t hash)
+	{
+		constexpr auto MaxDumpedRanges = std::size_t{64};
+
+		const auto same = std::find_if(dumpedRanges.begin(), dumpedRanges.end(), [&](const DumpedRange& range) { return range.offset == offset && range.length == length; });
+
+		if (same != dumpedRanges.end() && same->hash == hash)
+			return false;
+
+		// Older overlapping dumps no longer describe the contents of the range.
+		std::erase_if(dumpedRanges, [&](const DumpedRange& range) { return range.offset < offset + length && offset < range.offset + range.length; });
+
+		// Forgetting a range only costs a redundant dump later.
+		if (dumpedRanges.size() >= MaxDumpedRanges)
+			dumpedRanges.erase(dumpedRanges.begin());
 
-		auto file = std::ofstream{path};
-		file.write(gpuMemory.get(), size);
+		dumpedRanges.push_back({offset, length, hash});
+		return true;
 	}
 
 }
@@ -0,0 +1,163 @@
+#include <OpenCLMocker/BuildService.hpp>
+
+#include <OpenCLMocker/CallbackDispatcher.hpp>
+#include <OpenCLMocker/Config.hpp>
+#include <OpenCLMocker/Device.hpp>
+#include <OpenCLMocker/ProgramCache.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+namespace OpenCL
+{
+
+	BuildService::BuildService(std::size_t threadCount_)
+		: threadCount(threadCount_ != 0 ? threadCount_ : std::max(std::thread::hardware_concurrency(), 1u))
+	{
+		// Builds use the cache and post their callbacks, constructing both first keeps them alive until the last
+		// build is joined.
+		ProgramCache::GetInstance();
+		CallbackDispatcher::GetInstance();
+	}
+
+	BuildService::~BuildService()
+	{
+		{
+			auto lock = std::lock_guard{mutex};
+			stopping = true;
+			queued.clear();
+		}
+
+		runStarted.notify_all();
+	}
+
+	BuildService& BuildService::GetInstance()
+	{
+		static auto instance = BuildService{Config::GetInstance().buildThreads};
+		return instance;
+	}
+
+	void BuildService::Submit(std::vector<Device*> devices, Build build, Build done)
+	{
+		auto lock = std::lock_guard{mutex};
+		queued.push_back({std::move(devices), std::move(build), std::move(done)});
+		StartQueued();
+	}
+
+	void BuildService::Run(const std::vector<Device*>& devices, const Build& build)
+	{
+		auto started = false;
+
+		{
+			auto lock = std::unique_lock{mutex};
+			queued.push_back({devices, nullptr, nullptr, &started});
+			StartQueued();
+			runStarted.wait(lock, [&]() { return started || stopping; });
+		}
+
+		// The service is being destroyed, nothing waits for the slots anymore.
+		if (!started)
+		{
+			build();
+			return;
+		}
+
+		const auto finish = [&]()
+		{
+			auto lock = std::lock_guard{mutex};
+			Release(devices);
+			StartQueued();
+		};
+
+		try
+		{
+			build();
+		}
+		catch (...)
+		{
+			finish();
+			throw;
+		}
+
+		finish();
+	}
+
+	bool BuildService::HasFreeSlots(const std::vector<Device*>& devices) const
+	{
+		return std::all_of(devices.begin(), devices.end(), [this](const Device* device)
+			{
+				const auto found = running.find(device);
+				return found == running.end() || found->second < std::max<std::size_t>(device->parallelBuilds, 1);
+			});
+	}
+
+	void BuildService::Acquire(const std::vector<Device*>& devices)
+	{
+		for (auto device : devices)
+			++running[device];
+	}
+
+	void BuildService::Release(const std::vector<Device*>& devices)
+	{
+		for (auto device : devices)
+		{
+			if (--running[device] == 0)
+				running.erase(device);
+		}
+	}
+
+	void BuildService::StartQueued()
+	{
+		// Devices an earlier queued build is waiting for.
+		auto blocked = std::unordered_set<const Device*>{};
+
+		for (auto it = queued.begin(); it != queued.end() && !stopping;)
+		{
+			const auto isBlocked = std::any_of(it->devices.begin(), it->devices.end(), [&](const Device* device) { return blocked.contains(device); });
+			// Builds run by Run need no build thread.
+			const auto hasThread = it->started != nullptr || activeJobs < threadCount;
+
+			if (isBlocked || !hasThread || !HasFreeSlots(it->devices))
+			{
+				blocked.insert(it->devices.begin(), it->devices.end());
+				++it;
+				continue;
+			}
+
+			Acquire(it->devices);
+
+			if (it->started != nullptr)
+			{
+				*it->started = true;
+				runStarted.notify_all();
+				it = queued.erase(it);
+				continue;
+			}
+
+			if (!threads.has_value())
+				threads.emplace(threadCount);
+
+			++activeJobs;
+
+			threads->Submit([this, job = std::move(*it)]()
+				{
+					job.build();
+
+					{
+						auto lock = std::lock_guard{mutex};
+						Release(job.devices);
+						--activeJobs;
+						StartQueued();
+					}
+
+					// Not on the build thread, a callback waiting for another build must not hold a build thread.
+					if (job.done)
+						CallbackDispatcher::GetInstance().Post(job.done);
+				});
+
+			it = queued.erase(it);
+		}
+	}
+
+}
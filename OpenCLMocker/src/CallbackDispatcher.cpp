@@ -0,0 +1,59 @@
+#include <OpenCLMocker/CallbackDispatcher.hpp>
+
+namespace OpenCL
+{
+
+	CallbackDispatcher::~CallbackDispatcher()
+	{
+		{
+			auto lock = std::lock_guard{mutex};
+			stopping = true;
+		}
+
+		hasWork.notify_one();
+
+		if (thread.joinable())
+			thread.join();
+	}
+
+	CallbackDispatcher& CallbackDispatcher::GetInstance()
+	{
+		static auto instance = CallbackDispatcher{};
+		return instance;
+	}
+
+	void CallbackDispatcher::Post(Callback callback)
+	{
+		{
+			auto lock = std::lock_guard{mutex};
+			callbacks.emplace_back(std::move(callback));
+
+			// Most hosts never register a callback, so the thread only starts with the first one.
+			if (!thread.joinable())
+				thread = std::thread{[this]() { Process(); }};
+		}
+
+		hasWork.notify_one();
+	}
+
+	void CallbackDispatcher::Process()
+	{
+		auto lock = std::unique_lock{mutex};
+
+		while (true)
+		{
+			hasWork.wait(lock, [this]() { return stopping || !callbacks.empty(); });
+
+			if (callbacks.empty())
+				return;
+
+			auto callback = std::move(callbacks.front());
+			callbacks.pop_front();
+
+			lock.unlock();
+			callback();
+			lock.lock();
+		}
+	}
+
+}
@@ -34,12 +34,62 @@ using nlohmann::json;
 
 namespace OpenCL
 {
+	static void to_json(json& j, const KernelCostConfig& c)
+	{
+		j = json{
+			{"name", c.name},
+			{"globalSize", c.globalSize},
+			{"overhead", c.overhead},
+			{"workItemCost", c.workItemCost},
+		};
+	}
+
+	static void from_json(const json& j, KernelCostConfig& c)
+	{
+		TryParse(j, c, name);
+		TryParse(j, c, globalSize);
+		TryParse(j, c, overhead);
+		TryParse(j, c, workItemCost);
+	}
+
+	static void to_json(json& j, const PerformanceConfig& c)
+	{
+		j = json{
+			{"hostToDeviceBandwidth", c.hostToDeviceBandwidth},
+			{"deviceToHostBandwidth", c.deviceToHostBandwidth},
+			{"deviceToDeviceBandwidth", c.deviceToDeviceBandwidth},
+			{"copyLatency", c.copyLatency},
+			{"cachedBuildLatency", c.cachedBuildLatency},
+			{"kernelOverhead", c.kernelOverhead},
+			{"workItemCost", c.workItemCost},
+			{"kernels", c.kernels},
+			{"computeEngines", c.computeEngines},
+			{"copyEngines", c.copyEngines},
+		};
+	}
+
+	static void from_json(const json& j, PerformanceConfig& c)
+	{
+		TryParse(j, c, hostToDeviceBandwidth);
+		TryParse(j, c, deviceToHostBandwidth);
+		TryParse(j, c, deviceToDeviceBandwidth);
+		TryParse(j, c, copyLatency);
+		TryParse(j, c, cachedBuildLatency);
+		TryParse(j, c, kernelOverhead);
+		TryParse(j, c, workItemCost);
+		TryParseVector(j, c, kernels);
+		TryParse(j, c, computeEngines);
+		TryParse(j, c, copyEngines);
+	}
+
 	static void to_json(json& j, const DeviceConfig& c)
 	{
 		j = json{
 			{"name", c.name},
 			{"version", c.version},
 			{"driver", c.driver},
+			{"parallelBuilds", c.parallelBuilds},
+			{"performance", c.performance},
 		};
 	}
 
@@ -48,6 +98,8 @@ namespace OpenCL
 		TryParse(j, c, name);
 		TryParse(j, c, version);
 		TryParse(j, c, driver);
+		TryParse(j, c, parallelBuilds);
+		TryParse(j, c, performance);
 	}
 
 	static void to_json(json& j, const PlatformConfig& c)
@@ -80,6 +132,20 @@ namespace OpenCL
 			j["dumpBuffersRoot"] = *c.dumpBuffersRoot;
 		if (!c.dumpBuffersOpFilter.empty())
 			j["dumpBuffersOpFilter"] = c.dumpBuffersOpFilter;
+		j["dumpStagingSize"] = c.dumpStagingSize;
+		j["dumpFormat"] = c.dumpFormat;
+		if (c.virtualTime)
+			j["virtualTime"] = c.virtualTime;
+		if (!c.kernelPlugins.empty())
+			j["kernelPlugins"] = c.kernelPlugins;
+		if (c.workerThreads != 0)
+			j["workerThreads"] = c.workerThreads;
+		if (c.buildThreads != 0)
+			j["buildThreads"] = c.buildThreads;
+		j["bufferPoolLimit"] = c.bufferPoolLimit;
+		j["parallelCopyThreshold"] = c.parallelCopyThreshold;
+		if (c.programCacheRoot.has_value())
+			j["programCacheRoot"] = *c.programCacheRoot;
 	}
 
 	void from_json(const json& j, Config& c)
@@ -87,6 +153,15 @@ namespace OpenCL
 		TryParseVector(j, c, platforms);
 		TryParse(j, c, dumpBuffersRoot);
 		TryParseVector(j, c, dumpBuffersOpFilter);
+		TryParse(j, c, dumpStagingSize);
+		TryParse(j, c, dumpFormat);
+		TryParse(j, c, virtualTime);
+		TryParseVector(j, c, kernelPlugins);
+		TryParse(j, c, workerThreads);
+		TryParse(j, c, buildThreads);
+		TryParse(j, c, bufferPoolLimit);
+		TryParse(j, c, parallelCopyThreshold);
+		TryParse(j, c, programCacheRoot);
 	}
 
 	Config::Config(const std::string& path)
@@ -125,5 +200,14 @@ namespace OpenCL
 	{
 		OverrideFromEnv((*this), dumpBuffersRoot, CLMOCKER_DUMP_BUFFERS_ROOT);
 		OverrideFromEnv((*this), dumpBuffersOpFilter, CLMOCKER_DUMP_BUFFERS_OP_FILTER);
+		OverrideFromEnv((*this), dumpStagingSize, CLMOCKER_DUMP_STAGING_SIZE);
+		OverrideFromEnv((*this), dumpFormat, CLMOCKER_DUMP_FORMAT);
+		OverrideFromEnv((*this), virtualTime, CLMOCKER_VIRTUAL_TIME);
+		OverrideFromEnv((*this), kernelPlugins, CLMOCKER_KERNEL_PLUGINS);
+		OverrideFromEnv((*this), workerThreads, CLMOCKER_WORKER_THREADS);
+		OverrideFromEnv((*this), buildThreads, CLMOCKER_BUILD_THREADS);
+		OverrideFromEnv((*this), bufferPoolLimit, CLMOCKER_BUFFER_POOL_LIMIT);
+		OverrideFromEnv((*this), parallelCopyThreshold, CLMOCKER_PARALLEL_COPY_THRESHOLD);
+		OverrideFromEnv((*this), programCacheRoot, CLMOCKER_PROGRAM_CACHE_ROOT);
 	}
 }
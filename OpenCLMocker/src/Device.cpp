@@ -6,11 +6,20 @@
 
 namespace OpenCL
 {
+    Device::Device(Platform* platform)
+        : clock(Config::GetInstance().virtualTime)
+        , _platform(platform)
+    {
+    }
+
     Device::Device(Platform* platform, const DeviceConfig& cfg)
         : Device(platform)
     {
         name = cfg.name;
         driver = cfg.driver;
         version = cfg.version;
+        parallelBuilds = cfg.parallelBuilds;
+        performance = PerformanceModel{cfg.performance};
+        engines = EngineSchedule{cfg.performance.computeEngines, cfg.performance.copyEngines};
     }
 }
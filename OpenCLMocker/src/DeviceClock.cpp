@@ -0,0 +1,64 @@
+#include <OpenCLMocker/DeviceClock.hpp>
+
+#include <thread>
+
+namespace OpenCL
+{
+
+	DeviceClock::DeviceClock(bool virtualTime)
+		: virtualTime(virtualTime)
+		, virtualNow(Clock::now().time_since_epoch().count())
+	{
+	}
+
+	DeviceClock::DeviceClock(DeviceClock&& other)
+		: virtualTime(other.virtualTime)
+		, virtualNow(other.virtualNow.load())
+	{
+	}
+
+	DeviceClock& DeviceClock::operator=(DeviceClock&& other)
+	{
+		virtualTime = other.virtualTime;
+		virtualNow = other.virtualNow.load();
+		return *this;
+	}
+
+	DeviceClock::TimePoint DeviceClock::Now() const
+	{
+		if (!virtualTime)
+			return Clock::now();
+
+		return TimePoint{Duration{virtualNow.load()}};
+	}
+
+	void DeviceClock::WaitUntil(const TimePoint& point)
+	{
+		if (!virtualTime)
+		{
+			const auto now = Clock::now();
+			if (point > now)
+				std::this_thread::sleep_for(point - now);
+			return;
+		}
+
+		const auto target = point.time_since_epoch().count();
+		auto current = virtualNow.load();
+
+		while (current < target && !virtualNow.compare_exchange_weak(current, target))
+		{
+		}
+	}
+
+	void DeviceClock::SleepFor(const Duration& duration)
+	{
+		if (!virtualTime)
+		{
+			std::this_thread::sleep_for(duration);
+			return;
+		}
+
+		virtualNow += duration.count();
+	}
+
+}
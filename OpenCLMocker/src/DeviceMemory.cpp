@@ -0,0 +1,110 @@
+#include <OpenCLMocker/DeviceMemory.hpp>
+
+#include <OpenCLMocker/Exception.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <utility>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		// Smaller allocations come from the heap, a mapping would round them up to a page and cost a syscall.
+		constexpr std::size_t MinMappedSize = 64 * 1024;
+		constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+	}
+
+	DeviceMemory::DeviceMemory(std::size_t size_)
+		: size(size_)
+	{
+		if (size < MinMappedSize)
+		{
+			data = new char[size]{};
+			return;
+		}
+
+#ifdef _WIN32
+		data = static_cast<char*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+		if (data == nullptr)
+			throw Exception{CL_MEM_OBJECT_ALLOCATION_FAILURE};
+#else
+		const auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+		if (ptr == MAP_FAILED)
+			throw Exception{CL_MEM_OBJECT_ALLOCATION_FAILURE};
+
+		data = static_cast<char*>(ptr);
+
+#ifdef MADV_HUGEPAGE
+		if (size >= HugePageSize)
+			madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+#endif
+
+		mapped = true;
+	}
+
+	DeviceMemory::DeviceMemory(DeviceMemory&& other) noexcept
+		: data(std::exchange(other.data, nullptr))
+		, size(std::exchange(other.size, 0))
+		, mapped(std::exchange(other.mapped, false))
+	{
+	}
+
+	DeviceMemory& DeviceMemory::operator=(DeviceMemory&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Free();
+			data = std::exchange(other.data, nullptr);
+			size = std::exchange(other.size, 0);
+			mapped = std::exchange(other.mapped, false);
+		}
+
+		return *this;
+	}
+
+	DeviceMemory::~DeviceMemory()
+	{
+		Free();
+	}
+
+	void DeviceMemory::Discard()
+	{
+		if (!mapped || size < HugePageSize)
+			return;
+
+#ifdef _WIN32
+		DiscardVirtualMemory(data, size);
+#else
+		madvise(data, size, MADV_DONTNEED);
+#endif
+	}
+
+	void DeviceMemory::Free()
+	{
+		if (data == nullptr)
+			return;
+
+		if (!mapped)
+			delete[] data;
+		else
+#ifdef _WIN32
+			VirtualFree(data, 0, MEM_RELEASE);
+#else
+			munmap(data, size);
+#endif
+
+		data = nullptr;
+		size = 0;
+		mapped = false;
+	}
+
+}
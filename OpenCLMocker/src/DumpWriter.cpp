@@ -0,0 +1,366 @@
+#include <OpenCLMocker/DumpWriter.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		struct FilePiece
+		{
+			const char* data;
+			std::size_t size;
+		};
+
+		// Appends all pieces with as few system calls as possible.
+		void AppendToFile(std::FILE* file, const std::vector<FilePiece>& pieces)
+		{
+#ifdef _WIN32
+			for (const auto& piece : pieces)
+				std::fwrite(piece.data, 1, piece.size, file);
+#else
+			const auto fd = fileno(file);
+			auto iov = std::vector<iovec>{};
+			iov.reserve(pieces.size());
+
+			for (const auto& piece : pieces)
+			{
+				if (piece.size != 0)
+					iov.push_back({const_cast<char*>(piece.data), piece.size});
+			}
+
+			for (auto first = std::size_t{0}; first < iov.size();)
+			{
+				const auto count = std::min<std::size_t>(iov.size() - first, IOV_MAX);
+				auto result = writev(fd, iov.data() + first, static_cast<int>(count));
+
+				if (result < 0)
+				{
+					std::cerr << "CL Mocker: Failed to write dump archive." << std::endl;
+					return;
+				}
+
+				// Skips what was written, a partial write leaves the current vector trimmed.
+				for (; first < iov.size() && static_cast<std::size_t>(result) >= iov[first].iov_len; ++first)
+					result -= static_cast<ssize_t>(iov[first].iov_len);
+
+				if (first < iov.size())
+				{
+					iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + result;
+					iov[first].iov_len -= static_cast<std::size_t>(result);
+				}
+			}
+#endif
+		}
+
+		unsigned long GetProcessId()
+		{
+#ifdef _WIN32
+			return GetCurrentProcessId();
+#else
+			return static_cast<unsigned long>(getpid());
+#endif
+		}
+	}
+
+	DumpWriter::DumpWriter(std::filesystem::path root_, DumpFormat format_, std::size_t capacity_)
+		: ring(std::make_unique_for_overwrite<char[]>(capacity_))
+		, capacity(capacity_)
+		, root(std::move(root_))
+		, format(format_)
+	{
+		writer = std::thread{[this]() { Process(); }};
+	}
+
+	DumpWriter& DumpWriter::GetInstance()
+	{
+		// Leaked, buffers can be dumped by static destructors. Pending dumps are written at exit instead.
+		static auto& instance = []() -> DumpWriter&
+		{
+			const auto& config = Config::GetInstance();
+			const auto format = config.dumpFormat == "archive" ? DumpFormat::Archive : DumpFormat::Files;
+
+			auto& writer = *new DumpWriter{config.dumpBuffersRoot.value_or("."), format, std::max<std::size_t>(config.dumpStagingSize, 1)};
+			std::atexit([]() { GetInstance().Stop(); });
+			return writer;
+		}();
+
+		return instance;
+	}
+
+	void DumpWriter::Submit(DumpInfo info, const char* data, std::size_t size)
+	{
+		auto entry = std::make_unique<Entry>();
+		entry->info = std::move(info);
+		entry->size = size;
+
+		auto lock = std::unique_lock{mutex};
+
+		if (size <= capacity)
+		{
+			// Entries are contiguous, the tail of the ring is skipped when the entry does not fit there.
+			hasSpace.wait(lock, [&]()
+				{
+					if (reserved == released)
+						reserved = released = 0;
+
+					const auto offset = reserved % capacity;
+					const auto padding = offset + size > capacity ? capacity - offset : 0;
+					return stopping || capacity - (reserved - released) >= padding + size;
+				});
+		}
+
+		if (stopping)
+		{
+			// The archive index is already written, late dumps can only go to separate files.
+			if (format == DumpFormat::Files)
+			{
+				entry->data = const_cast<char*>(data);
+				WriteFile(*entry);
+			}
+
+			return;
+		}
+
+		if (size > capacity)
+		{
+			entry->oversized = std::make_unique_for_overwrite<char[]>(size);
+			entry->data = entry->oversized.get();
+		}
+		else
+		{
+			const auto offset = reserved % capacity;
+			const auto padding = offset + size > capacity ? capacity - offset : 0;
+
+			entry->data = ring.get() + (offset + padding) % capacity;
+			entry->reserved = padding + size;
+			reserved += entry->reserved;
+		}
+
+		auto& staged = *entry;
+		entries.emplace_back(std::move(entry));
+		++submittedCount;
+		lock.unlock();
+
+		std::memcpy(staged.data, data, size);
+		staged.ready = true;
+
+		// Synchronizes with the writer checking the flag, so the notification is not lost.
+		lock.lock();
+		lock.unlock();
+		hasWork.notify_one();
+	}
+
+	void DumpWriter::Flush()
+	{
+		auto lock = std::unique_lock{mutex};
+		const auto target = submittedCount;
+
+		hasSpace.wait(lock, [&]() { return writtenCount >= target; });
+	}
+
+	void DumpWriter::Process()
+	{
+		auto batch = std::vector<std::unique_ptr<Entry>>{};
+
+		while (true)
+		{
+			{
+				auto lock = std::unique_lock{mutex};
+
+				hasWork.wait(lock, [&]() { return stopping && entries.empty() || !entries.empty() && entries.front()->ready; });
+
+				if (entries.empty())
+					return;
+
+				while (!entries.empty() && entries.front()->ready)
+				{
+					batch.emplace_back(std::move(entries.front()));
+					entries.pop_front();
+				}
+			}
+
+			Write(batch);
+
+			{
+				auto lock = std::lock_guard{mutex};
+
+				for (const auto& entry : batch)
+					released += entry->reserved;
+
+				writtenCount += batch.size();
+			}
+
+			batch.clear();
+			hasSpace.notify_all();
+		}
+	}
+
+	void DumpWriter::Write(const std::vector<std::unique_ptr<Entry>>& entries)
+	{
+		if (!createdRoot)
+		{
+			std::filesystem::create_directories(root);
+			createdRoot = true;
+		}
+
+		if (format == DumpFormat::Archive)
+		{
+			WriteArchive(entries);
+			return;
+		}
+
+		for (const auto& entry : entries)
+			WriteFile(*entry);
+	}
+
+	void DumpWriter::WriteFile(const Entry& entry)
+	{
+		const auto& info = entry.info;
+		const auto range = info.bufferOffset != 0 || entry.size != info.bufferSize ? "@" + std::to_string(info.bufferOffset) : std::string{};
+		const auto filename = std::to_string(info.globalSequence) + "_" + std::to_string(info.bufferId) + "_" + std::to_string(info.sequence) + "_" + info.operation + range + ".buffer";
+		const auto path = root / filename;
+
+#ifdef _WIN32
+		auto file = std::ofstream{path, std::ios::binary};
+		file.write(entry.data, entry.size);
+#else
+		const auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (fd < 0)
+		{
+			std::cerr << "CL Mocker: Failed to create dump " << path << "." << std::endl;
+			return;
+		}
+
+		for (auto written = std::size_t{0}; written < entry.size;)
+		{
+			const auto result = write(fd, entry.data + written, entry.size - written);
+
+			if (result <= 0)
+			{
+				std::cerr << "CL Mocker: Failed to write dump " << path << "." << std::endl;
+				break;
+			}
+
+			written += static_cast<std::size_t>(result);
+		}
+
+		close(fd);
+#endif
+	}
+
+	void DumpWriter::WriteArchive(const std::vector<std::unique_ptr<Entry>>& entries)
+	{
+		static constexpr char padding[8] = {};
+
+		if (archive == nullptr)
+		{
+			const auto path = root / ("dump_" + std::to_string(GetProcessId()) + ".cldump");
+			archive = std::fopen(path.string().c_str(), "wb");
+
+			if (archive == nullptr)
+			{
+				std::cerr << "CL Mocker: Failed to create dump archive " << path << "." << std::endl;
+				format = DumpFormat::Files;
+				Write(entries);
+				return;
+			}
+
+			const auto header = Dump::ArchiveHeader{Dump::ArchiveMagic, Dump::ArchiveVersion};
+			AppendToFile(archive, {{reinterpret_cast<const char*>(&header), sizeof(header)}});
+			archiveSize = sizeof(header);
+		}
+
+		auto headers = std::vector<Dump::ArchiveEntry>(entries.size());
+		auto pieces = std::vector<FilePiece>{};
+		pieces.reserve(entries.size() * 5);
+
+		for (auto i = std::size_t{0}; i < entries.size(); ++i)
+		{
+			const auto& entry = *entries[i];
+			const auto& info = entry.info;
+			auto& header = headers[i];
+
+			header.magic = Dump::EntryMagic;
+			header.operationLength = static_cast<std::uint32_t>(info.operation.size());
+			header.bufferId = info.bufferId;
+			header.sequence = info.sequence;
+			header.globalSequence = info.globalSequence;
+			header.bufferOffset = info.bufferOffset;
+			header.length = entry.size;
+			header.bufferSize = info.bufferSize;
+			header.hash = info.hash;
+			header.operationOffset = 0;
+			header.dataOffset = 0;
+
+			const auto operationSize = Dump::PadTo8(info.operation.size());
+			const auto dataSize = Dump::PadTo8(entry.size);
+
+			pieces.push_back({reinterpret_cast<const char*>(&header), sizeof(header)});
+			pieces.push_back({info.operation.data(), info.operation.size()});
+			pieces.push_back({padding, operationSize - info.operation.size()});
+			pieces.push_back({entry.data, entry.size});
+			pieces.push_back({padding, dataSize - entry.size});
+
+			auto indexed = header;
+			indexed.operationOffset = archiveSize + sizeof(header);
+			indexed.dataOffset = indexed.operationOffset + operationSize;
+			archiveIndex.push_back(indexed);
+
+			archiveSize = indexed.dataOffset + dataSize;
+		}
+
+		AppendToFile(archive, pieces);
+	}
+
+	void DumpWriter::CloseArchive()
+	{
+		if (archive == nullptr)
+			return;
+
+		const auto footer = Dump::ArchiveFooter{archiveSize, archiveIndex.size(), Dump::FooterMagic, Dump::ArchiveVersion};
+
+		AppendToFile(archive, {
+			{reinterpret_cast<const char*>(archiveIndex.data()), archiveIndex.size() * sizeof(Dump::ArchiveEntry)},
+			{reinterpret_cast<const char*>(&footer), sizeof(footer)},
+		});
+
+		std::fclose(archive);
+		archive = nullptr;
+	}
+
+	void DumpWriter::Stop()
+	{
+		{
+			auto lock = std::lock_guard{mutex};
+			stopping = true;
+		}
+
+		hasWork.notify_all();
+		hasSpace.notify_all();
+
+		if (writer.joinable())
+			writer.join();
+
+		CloseArchive();
+	}
+
+}
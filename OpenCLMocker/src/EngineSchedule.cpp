@@ -0,0 +1,64 @@
+#include <OpenCLMocker/EngineSchedule.hpp>
+
+#include <algorithm>
+
+namespace OpenCL
+{
+
+	EngineSchedule::EngineSchedule(std::size_t computeEngines, std::size_t copyEngines)
+		: compute(std::max<std::size_t>(computeEngines, 1))
+		, copy(std::max<std::size_t>(copyEngines, 1))
+	{
+	}
+
+	EngineSchedule::EngineSchedule(EngineSchedule&& other)
+		: compute(std::move(other.compute))
+		, copy(std::move(other.copy))
+	{
+	}
+
+	EngineSchedule& EngineSchedule::operator=(EngineSchedule&& other)
+	{
+		compute = std::move(other.compute);
+		copy = std::move(other.copy);
+		return *this;
+	}
+
+	EngineType EngineSchedule::GetEngineType(cl_command_type type)
+	{
+		switch (type)
+		{
+		case CL_COMMAND_NDRANGE_KERNEL:
+		case CL_COMMAND_TASK:
+		case CL_COMMAND_NATIVE_KERNEL:
+			return EngineType::Compute;
+		case CL_COMMAND_READ_BUFFER:
+		case CL_COMMAND_WRITE_BUFFER:
+		case CL_COMMAND_COPY_BUFFER:
+		case CL_COMMAND_READ_BUFFER_RECT:
+		case CL_COMMAND_WRITE_BUFFER_RECT:
+		case CL_COMMAND_COPY_BUFFER_RECT:
+		case CL_COMMAND_FILL_BUFFER:
+		case CL_COMMAND_MAP_BUFFER:
+		case CL_COMMAND_UNMAP_MEM_OBJECT:
+			return EngineType::Copy;
+		default:
+			return EngineType::None;
+		}
+	}
+
+	DeviceClock::TimePoint EngineSchedule::Reserve(EngineType type, const DeviceClock::TimePoint& earliest, const DeviceClock::Duration& duration)
+	{
+		if (type == EngineType::None)
+			return earliest;
+
+		auto lock = std::lock_guard{mutex};
+		auto& engines = type == EngineType::Compute ? compute : copy;
+		auto& engine = *std::min_element(engines.begin(), engines.end());
+		const auto start = std::max(engine, earliest);
+
+		engine = start + duration;
+		return start;
+	}
+
+}
@@ -1,9 +1,55 @@
 #include <OpenCLMocker/Environment.hpp>
 
+#include <cstdlib>
+#include <string_view>
+
+#ifdef _WIN32
+#define environ _environ
+#else
+extern char** environ;
+#endif
+
 namespace OpenCL
 {
-	std::map<std::string, EnvVariable> EnvVariable::values;
+	const std::optional<std::string>& EnvVariable::Get(const std::string& name)
+	{
+		static const auto unset = std::optional<std::string>{};
+
+		const auto& snapshot = GetSnapshot();
+		const auto found = snapshot.find(name);
+		return found != snapshot.end() ? found->second : unset;
+	}
+
+	const std::map<std::string, std::optional<std::string>, std::less<>>& EnvVariable::GetSnapshot()
+	{
+		static const auto snapshot = []()
+		{
+			auto variables = std::map<std::string, std::optional<std::string>, std::less<>>{};
+
+			for (auto entry = environ; entry != nullptr && *entry != nullptr; ++entry)
+			{
+				const auto variable = std::string_view{*entry};
+				const auto separator = variable.find('=');
+
+				if (separator != std::string_view::npos)
+					variables.emplace(variable.substr(0, separator), std::string{variable.substr(separator + 1)});
+			}
+
+			return variables;
+		}();
+
+		return snapshot;
+	}
 
 	DEFINE_ENV_VARIABLE(CLMOCKER_DUMP_BUFFERS_ROOT, std::filesystem::path, std::nullopt);
 	DEFINE_ENV_VARIABLE(CLMOCKER_DUMP_BUFFERS_OP_FILTER, std::vector<std::string>, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_DUMP_STAGING_SIZE, std::size_t, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_DUMP_FORMAT, std::string, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_VIRTUAL_TIME, bool, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_KERNEL_PLUGINS, std::vector<std::filesystem::path>, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_WORKER_THREADS, std::size_t, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_BUILD_THREADS, std::size_t, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_BUFFER_POOL_LIMIT, std::size_t, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_PARALLEL_COPY_THRESHOLD, std::size_t, std::nullopt);
+	DEFINE_ENV_VARIABLE(CLMOCKER_PROGRAM_CACHE_ROOT, std::filesystem::path, std::nullopt);
 }
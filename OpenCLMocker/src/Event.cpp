@@ -1,13 +1,181 @@
 #include <OpenCLMocker/Event.hpp>
 
+#include <OpenCLMocker/CallbackDispatcher.hpp>
+#include <OpenCLMocker/Context.hpp>
+#include <OpenCLMocker/Device.hpp>
 #include <OpenCLMocker/Queue.hpp>
+#include <OpenCLMocker/Retained.hpp>
+
+#include <algorithm>
+#include <utility>
 
 namespace OpenCL
 {
 
-	Event::~Event()
+	Event::Event(Queue& queue, cl_command_type type, const DeviceClock::Duration& duration)
+		: ctx(queue.ctx)
+		, queue(&queue)
+		, clock(&queue.device->clock)
+		, type(type)
+		, duration(duration)
+		, queued(clock->Now())
+		, submitted(queued)
+		, start(queued)
+		, end(queued)
+	{
+	}
+
+	Event::Event(Context& context)
+		: ctx(&context)
+		, queue(nullptr)
+		, clock(&context.devices.front()->clock)
+		, type(CL_COMMAND_USER)
+		, duration{}
+		, status(CL_SUBMITTED)
+		, queued(clock->Now())
+		, submitted(queued)
+		, start(queued)
+		, end(queued)
+	{
+	}
+
+	void Event::WaitForCompletion() const
 	{
-		queue->UnregisterEvent(this);
+		if (IsFinished())
+			return;
+
+		if (queue != nullptr)
+			queue->Flush();
+
+		for (auto current = status.load(); current > CL_COMPLETE; current = status.load())
+			status.wait(current);
+	}
+
+	void Event::Wait() const
+	{
+		if (!Validate(this))
+			return;
+
+		WaitForCompletion();
+		clock->WaitUntil(end);
+	}
+
+	void Event::WaitForAll(const std::vector<const Event*>& events)
+	{
+		for (const auto event : events)
+			if (!event->IsFinished() && event->queue != nullptr)
+				event->queue->Flush();
+
+		auto ends = std::vector<std::pair<DeviceClock*, TimePoint>>{};
+
+		for (const auto event : events)
+		{
+			event->WaitForCompletion();
+
+			const auto found = std::find_if(ends.begin(), ends.end(), [&](const auto& end) { return end.first == event->clock; });
+
+			if (found == ends.end())
+				ends.emplace_back(event->clock, event->end);
+			else
+				found->second = std::max(found->second, event->end);
+		}
+
+		for (const auto& [clock, end] : ends)
+			clock->WaitUntil(end);
+	}
+
+	bool Event::AddCompletionHook(std::function<void()> hook)
+	{
+		auto lock = std::lock_guard{mutex};
+
+		if (IsFinished())
+			return false;
+
+		completionHooks.emplace_back(std::move(hook));
+		return true;
+	}
+
+	void Event::AddCallback(cl_int callbackType, CallbackFunction function, void* userData)
+	{
+		auto lock = std::lock_guard{mutex};
+		callbacks.push_back({callbackType, function, userData});
+		hasCallbacks = true;
+		DispatchCallbacks();
+	}
+
+	void Event::Submit(const TimePoint& time)
+	{
+		submitted = time;
+		status = CL_SUBMITTED;
+
+		if (hasCallbacks)
+		{
+			auto lock = std::lock_guard{mutex};
+			DispatchCallbacks();
+		}
+	}
+
+	void Event::Run(const TimePoint& time)
+	{
+		start = time;
+		end = start + duration;
+		status = CL_RUNNING;
+
+		if (hasCallbacks)
+		{
+			auto lock = std::lock_guard{mutex};
+			DispatchCallbacks();
+		}
+	}
+
+	void Event::Complete(cl_int result)
+	{
+		auto hooks = std::vector<std::function<void()>>{};
+
+		{
+			auto lock = std::lock_guard{mutex};
+			status = result;
+			hooks = std::move(completionHooks);
+			DispatchCallbacks();
+		}
+
+		status.notify_all();
+
+		for (const auto& hook : hooks)
+			hook();
+	}
+
+	void Event::SetUserStatus(cl_int result)
+	{
+		start = clock->Now();
+		end = start;
+		Complete(result);
+	}
+
+	void Event::DispatchCallbacks()
+	{
+		const auto current = status.load();
+		auto& dispatcher = CallbackDispatcher::GetInstance();
+
+		// Earlier states first, a command going straight to complete still reports submitted and running.
+		for (const auto type : {CL_SUBMITTED, CL_RUNNING, CL_COMPLETE})
+		{
+			if (current > type)
+				break;
+
+			for (const auto& callback : callbacks)
+			{
+				if (callback.type != type)
+					continue;
+
+				dispatcher.Post([event = Retained{*this}, callback, reported = current < 0 ? current : type]()
+					{
+						callback.function(MapType(*event), reported, callback.userData);
+					});
+			}
+		}
+
+		std::erase_if(callbacks, [&](const auto& callback) { return current <= callback.type; });
 	}
 
 }
@@ -0,0 +1,162 @@
+#include <OpenCLMocker/HandleTable.hpp>
+
+#include <OpenCLMocker/Object.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		constexpr std::size_t CacheSize = 64;
+
+		struct FreeSlots
+		{
+			std::mutex mutex;
+			std::vector<std::size_t> indices;
+			std::size_t used = 0;
+		};
+
+		// Leaked, objects can be released by static destructors of other translation units.
+		FreeSlots& GetFreeSlots()
+		{
+			static auto& freeSlots = *new FreeSlots{};
+			return freeSlots;
+		}
+
+		thread_local bool cacheDestroyed = false;
+
+		// Free slots of the thread, so that creating and releasing objects does not contend on the shared list.
+		struct SlotCache
+		{
+			std::vector<std::size_t> indices;
+
+			static SlotCache& Get()
+			{
+				thread_local auto cache = SlotCache{};
+				return cache;
+			}
+
+			// Moves the newest `count` slots to the shared list.
+			void GiveBack(std::size_t count)
+			{
+				auto& freeSlots = GetFreeSlots();
+				auto lock = std::lock_guard{freeSlots.mutex};
+				freeSlots.indices.insert(freeSlots.indices.end(), indices.end() - count, indices.end());
+				indices.resize(indices.size() - count);
+			}
+
+			~SlotCache()
+			{
+				GiveBack(indices.size());
+				cacheDestroyed = true;
+			}
+		};
+	}
+
+	Handle HandleTable::Add(std::unique_ptr<Object> object, HandleType type)
+	{
+		const auto index = TakeFreeSlot();
+		auto& slot = slabs[index / SlabSize].load(std::memory_order_relaxed)[index % SlabSize];
+		slot.generation = (slot.generation + 1) & GenerationMask;
+
+		const auto handle = static_cast<Handle>(type) << TypeShift | slot.generation << GenerationShift | (index + 1);
+
+		slot.object = object.release();
+		slot.useCount.store(1, std::memory_order_relaxed);
+		slot.handle.store(handle, std::memory_order_release);
+
+		return handle;
+	}
+
+	void HandleTable::Retain(Handle handle)
+	{
+		GetSlot(handle)->useCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	bool HandleTable::Release(Handle handle)
+	{
+		auto& slot = *GetSlot(handle);
+
+		if (slot.useCount.fetch_sub(1, std::memory_order_acq_rel) > 1)
+			return false;
+
+		slot.handle.store(0, std::memory_order_release);
+		delete std::exchange(slot.object, nullptr);
+
+		const auto index = (handle & IndexMask) - 1;
+
+		if (cacheDestroyed)
+		{
+			auto& freeSlots = GetFreeSlots();
+			auto lock = std::lock_guard{freeSlots.mutex};
+			freeSlots.indices.push_back(index);
+			return true;
+		}
+
+		auto& cache = SlotCache::Get();
+
+		if (cache.indices.size() >= CacheSize)
+			cache.GiveBack(CacheSize / 2);
+
+		cache.indices.push_back(index);
+		return true;
+	}
+
+	int HandleTable::GetReferenceCount(Handle handle)
+	{
+		return GetSlot(handle)->useCount.load(std::memory_order_relaxed);
+	}
+
+	std::size_t HandleTable::TakeFreeSlot()
+	{
+		auto& freeSlots = GetFreeSlots();
+
+		if (cacheDestroyed)
+		{
+			auto lock = std::lock_guard{freeSlots.mutex};
+			return TakeSharedSlots(freeSlots.indices, freeSlots.used, 1).back();
+		}
+
+		auto& cache = SlotCache::Get();
+
+		if (cache.indices.empty())
+		{
+			auto lock = std::lock_guard{freeSlots.mutex};
+			cache.indices = TakeSharedSlots(freeSlots.indices, freeSlots.used, CacheSize / 2);
+		}
+
+		const auto index = cache.indices.back();
+		cache.indices.pop_back();
+		return index;
+	}
+
+	std::vector<std::size_t> HandleTable::TakeSharedSlots(std::vector<std::size_t>& indices, std::size_t& used, std::size_t count)
+	{
+		const auto reused = std::min(count, indices.size());
+		auto taken = std::vector<std::size_t>{indices.end() - reused, indices.end()};
+		indices.resize(indices.size() - reused);
+
+		// Never used slots go to the front, the cache hands out slots from the back.
+		for (auto i = reused; i < count && used < SlabSize * MaxSlabs; ++i)
+		{
+			const auto index = used++;
+
+			if (index % SlabSize == 0)
+				slabs[index / SlabSize].store(new Slot[SlabSize], std::memory_order_release);
+
+			taken.insert(taken.begin(), index);
+		}
+
+		if (taken.empty())
+			throw std::bad_alloc{};
+
+		return taken;
+	}
+
+}
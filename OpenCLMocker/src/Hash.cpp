@@ -0,0 +1,100 @@
+#include <OpenCLMocker/Hash.hpp>
+
+#include <cstring>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+		constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+		constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+		constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+		constexpr std::uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+		std::uint64_t RotateLeft(std::uint64_t value, int bits) { return value << bits | value >> (64 - bits); }
+
+		std::uint64_t Read64(const unsigned char* ptr)
+		{
+			auto value = std::uint64_t{};
+			std::memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+
+		std::uint32_t Read32(const unsigned char* ptr)
+		{
+			auto value = std::uint32_t{};
+			std::memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+
+		std::uint64_t Round(std::uint64_t acc, std::uint64_t input)
+		{
+			acc += input * Prime2;
+			acc = RotateLeft(acc, 31);
+			return acc * Prime1;
+		}
+
+		std::uint64_t MergeRound(std::uint64_t acc, std::uint64_t value)
+		{
+			acc ^= Round(0, value);
+			return acc * Prime1 + Prime4;
+		}
+	}
+
+	std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed)
+	{
+		auto ptr = static_cast<const unsigned char*>(data);
+		const auto end = ptr + size;
+		auto hash = std::uint64_t{};
+
+		if (size >= 32)
+		{
+			auto v1 = seed + Prime1 + Prime2;
+			auto v2 = seed + Prime2;
+			auto v3 = seed;
+			auto v4 = seed - Prime1;
+
+			for (const auto limit = end - 32; ptr <= limit; ptr += 32)
+			{
+				v1 = Round(v1, Read64(ptr));
+				v2 = Round(v2, Read64(ptr + 8));
+				v3 = Round(v3, Read64(ptr + 16));
+				v4 = Round(v4, Read64(ptr + 24));
+			}
+
+			hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+			hash = MergeRound(hash, v1);
+			hash = MergeRound(hash, v2);
+			hash = MergeRound(hash, v3);
+			hash = MergeRound(hash, v4);
+		}
+		else
+		{
+			hash = seed + Prime5;
+		}
+
+		hash += static_cast<std::uint64_t>(size);
+
+		for (; ptr + 8 <= end; ptr += 8)
+			hash = RotateLeft(hash ^ Round(0, Read64(ptr)), 27) * Prime1 + Prime4;
+
+		if (ptr + 4 <= end)
+		{
+			hash = RotateLeft(hash ^ Read32(ptr) * Prime1, 23) * Prime2 + Prime3;
+			ptr += 4;
+		}
+
+		for (; ptr < end; ++ptr)
+			hash = RotateLeft(hash ^ *ptr * Prime5, 11) * Prime1;
+
+		hash ^= hash >> 33;
+		hash *= Prime2;
+		hash ^= hash >> 29;
+		hash *= Prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+}
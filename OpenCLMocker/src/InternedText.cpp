@@ -0,0 +1,84 @@
+#include <OpenCLMocker/InternedText.hpp>
+
+#include <OpenCLMocker/Hash.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		struct Pool
+		{
+			std::mutex mutex;
+			// Texts by hash, the raw pointer tells an expired entry from its replacement.
+			std::unordered_multimap<std::uint64_t, std::pair<const void*, std::weak_ptr<const void>>> entries;
+		};
+
+		// Leaked, programs can be released by static destructors of other translation units.
+		Pool& GetPool()
+		{
+			static auto& pool = *new Pool{};
+			return pool;
+		}
+	}
+
+	InternedText InternedText::Get(std::string_view text)
+	{
+		return Intern(text);
+	}
+
+	InternedText InternedText::Get(std::string&& text)
+	{
+		return Intern(std::move(text));
+	}
+
+	template <class TText>
+	InternedText InternedText::Intern(TText&& text)
+	{
+		const auto view = std::string_view{text};
+		const auto hash = Hash64(view.data(), view.size());
+		auto& pool = GetPool();
+		auto ret = InternedText{};
+
+		auto lock = std::lock_guard{pool.mutex};
+		const auto [begin, end] = pool.entries.equal_range(hash);
+
+		for (auto it = begin; it != end; ++it)
+		{
+			// Expired entries are still in the pool until their deleter takes the lock.
+			auto entry = std::static_pointer_cast<const Entry>(it->second.second.lock());
+
+			if (entry != nullptr && entry->text == view)
+			{
+				ret.entry = std::move(entry);
+				return ret;
+			}
+		}
+
+		const auto deleter = [](const Entry* entry)
+		{
+			auto& pool = GetPool();
+
+			{
+				auto lock = std::lock_guard{pool.mutex};
+				const auto [begin, end] = pool.entries.equal_range(entry->hash);
+				const auto found = std::find_if(begin, end, [&](const auto& item) { return item.second.first == entry; });
+
+				if (found != end)
+					pool.entries.erase(found);
+			}
+
+			delete entry;
+		};
+
+		ret.entry = std::shared_ptr<const Entry>{new Entry{std::string{std::forward<TText>(text)}, hash}, deleter};
+		pool.entries.emplace(hash, std::pair{static_cast<const void*>(ret.entry.get()), std::weak_ptr<const void>{ret.entry}});
+		return ret;
+	}
+
+}
@@ -1,22 +1,112 @@
 #include <OpenCLMocker/Kernel.hpp>
 
-#include <OpenCLMocker/Exception.hpp>
-
 #include <cstring>
-#include <vector>
+#include <string>
+#include <utility>
 
 namespace OpenCL
 {
 
-	void Kernel::SetArg(cl_uint index, size_t size, const void* value)
+	const void* KernelArgs::GetValue(std::size_t index) const
+	{
+		const auto& slot = slots[index];
+
+		if (!slot.isSet || slot.isLocal)
+			return nullptr;
+
+		return slot.size <= InlineSize ? static_cast<const void*>(slot.value.data()) : overflow.data() + slot.offset;
+	}
+
+	void* KernelArgs::Reserve(Slot& slot, std::size_t size)
+	{
+		const auto units = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+
+		// Values which fit in the space the argument had keep it, so setting an argument again does not grow the area.
+		if (slot.capacity < units)
+		{
+			slot.offset = overflow.size();
+			slot.capacity = units;
+			overflow.resize(overflow.size() + units);
+		}
+
+		return overflow.data() + slot.offset;
+	}
+
+	Kernel::Kernel(std::shared_ptr<const KernelSignature> signature_)
+		: signature(std::move(signature_))
+		, args(signature != nullptr ? signature->args.size() : 0)
 	{
-		if (index < 0) // Todo: upper limit check
-			throw Exception(CL_INVALID_ARG_INDEX);
+	}
 
-		auto& arg = args[index];
+	Kernel::~Kernel()
+	{
+		if (program)
+			program->DetachKernel();
+	}
+
+	cl_int Kernel::SetArg(cl_uint index, size_t size, const void* value)
+	{
+		if (signature != nullptr)
+		{
+			if (index >= signature->args.size())
+				return CL_INVALID_ARG_INDEX;
+
+			const auto& expected = signature->args[index];
+
+			if (expected.IsLocal() && value != nullptr)
+				return CL_INVALID_ARG_VALUE;
+			if (!expected.IsLocal() && expected.size != 0 && size != expected.size)
+				return CL_INVALID_ARG_SIZE;
+
+			if (value == nullptr && !expected.IsLocal())
+			{
+				if (!expected.isPointer)
+					return CL_INVALID_ARG_VALUE;
+
+				// A null buffer, the argument still has a value.
+				static constexpr auto NullBuffer = cl_mem{nullptr};
+				value = &NullBuffer;
+			}
+		}
+
+		if (signature == nullptr && index >= MaxUndeclaredArgs)
+			return CL_INVALID_ARG_INDEX;
+
+		if (value == nullptr)
+		{
+			if (size == 0)
+				return CL_INVALID_ARG_SIZE;
+
+			args.SetLocal(index, size);
+			return CL_SUCCESS;
+		}
+
+		args.Set(index, size, value);
+		return CL_SUCCESS;
+	}
+
+	std::string Kernel::DescribeArgError(cl_int status, cl_uint index, size_t size, const void* value) const
+	{
+		const auto expected = signature != nullptr && index < signature->args.size() ? &signature->args[index] : nullptr;
+		auto description = "clSetKernelArg: argument " + std::to_string(index) + (expected != nullptr ? " (" + expected->name + ")" : "") + " of kernel " + name;
 
-		arg.value.resize(size);
-		std::memcpy(arg.value.data(), value, size);
+		switch (status)
+		{
+		case CL_INVALID_ARG_INDEX:
+			return signature != nullptr
+				? description + " is out of range, the kernel declares " + std::to_string(signature->args.size()) + " arguments."
+				: description + " is out of range, kernels without a declaration take at most " + std::to_string(MaxUndeclaredArgs) + " arguments.";
+		case CL_INVALID_ARG_SIZE:
+			if (expected != nullptr && !expected->IsLocal() && expected->size != 0 && size != expected->size)
+				return description + " has size " + std::to_string(size) + ", " + expected->typeName + " takes " + std::to_string(expected->size) + ".";
+			return description + " is __local, its size should not be 0.";
+		case CL_INVALID_ARG_VALUE:
+			if (expected != nullptr && expected->IsLocal() && value != nullptr)
+				return description + " is __local, its value should be nullptr.";
+			return description + " is " + (expected != nullptr ? expected->typeName : "not a pointer") + ", its value should not be nullptr.";
+		default:
+			return description + " could not be set.";
+		}
 	}
 
 }
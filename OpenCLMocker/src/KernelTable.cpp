@@ -0,0 +1,914 @@
+#include <OpenCLMocker/KernelTable.hpp>
+
+#include <OpenCLMocker/Hash.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		enum class TokenKind
+		{
+			Identifier,
+			Number,
+			String,
+			Punctuator,
+		};
+
+		struct Token
+		{
+			TokenKind kind;
+			// Points into the source or the storage of the preprocessor.
+			std::string_view text;
+			// Whitespace before the token, it tells `#define F(x)` from `#define F (x)`.
+			bool spaced = false;
+
+			bool Is(std::string_view punctuator) const { return kind == TokenKind::Punctuator && text == punctuator; }
+		};
+
+		using Tokens = std::vector<Token>;
+
+		struct Macro
+		{
+			bool isFunction = false;
+			// The last parameter is __VA_ARGS__, which takes the remaining arguments.
+			bool isVariadic = false;
+			std::vector<std::string_view> params;
+			Tokens body;
+		};
+
+		constexpr auto TwoCharPunctuators = std::array<std::string_view, 12>{"##", "&&", "||", "==", "!=", "<=", ">=", "<<", ">>", "->", "++", "--"};
+
+		bool IsIdentifierStart(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+		bool IsIdentifierChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+		bool IsDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+		TokenKind GetKind(std::string_view text)
+		{
+			if (text.empty() || IsIdentifierStart(text.front()))
+				return TokenKind::Identifier;
+			return IsDigit(text.front()) ? TokenKind::Number : TokenKind::Punctuator;
+		}
+
+		// Splits the source into logical lines of tokens, dropping comments and line continuations.
+		class Lexer
+		{
+		public:
+			explicit Lexer(std::string_view source_)
+				: source(source_)
+			{
+			}
+
+			// Returns false at the end of the source.
+			bool NextLine(Tokens& tokens)
+			{
+				tokens.clear();
+
+				if (pos >= source.size())
+					return false;
+
+				auto spaced = false;
+
+				while (pos < source.size())
+				{
+					const auto c = source[pos];
+					const auto next = pos + 1 < source.size() ? source[pos + 1] : '\0';
+
+					if (c == '\n')
+					{
+						++pos;
+						break;
+					}
+
+					if (c == '\\' && (next == '\n' || next == '\r'))
+					{
+						// The backslash and a LF, a CR LF or a lone CR.
+						pos += next == '\r' && pos + 2 < source.size() && source[pos + 2] == '\n' ? 3 : 2;
+						spaced = true;
+						continue;
+					}
+
+					if (std::isspace(static_cast<unsigned char>(c)))
+					{
+						++pos;
+						spaced = true;
+						continue;
+					}
+
+					if (c == '/' && next == '/')
+					{
+						pos = std::min(source.find('\n', pos), source.size());
+						continue;
+					}
+
+					if (c == '/' && next == '*')
+					{
+						const auto end = source.find("*/", pos + 2);
+						pos = end == std::string_view::npos ? source.size() : end + 2;
+						spaced = true;
+						continue;
+					}
+
+					const auto begin = pos;
+					auto kind = TokenKind::Punctuator;
+
+					if (IsIdentifierStart(c))
+					{
+						kind = TokenKind::Identifier;
+						while (pos < source.size() && IsIdentifierChar(source[pos]))
+							++pos;
+					}
+					else if (IsDigit(c) || (c == '.' && IsDigit(next)))
+					{
+						kind = TokenKind::Number;
+						for (++pos; pos < source.size(); ++pos)
+						{
+							const auto exponentSign = (source[pos] == '+' || source[pos] == '-') && std::string_view{"eEpP"}.find(source[pos - 1]) != std::string_view::npos;
+
+							if (!IsIdentifierChar(source[pos]) && source[pos] != '.' && !exponentSign)
+								break;
+						}
+					}
+					else if (c == '"' || c == '\'')
+					{
+						kind = TokenKind::String;
+						for (++pos; pos < source.size() && source[pos] != c && source[pos] != '\n'; ++pos)
+						{
+							if (source[pos] == '\\')
+								++pos;
+						}
+						pos = std::min(pos + 1, source.size());
+					}
+					else if (source.substr(pos, 3) == "...")
+					{
+						pos += 3;
+					}
+					else
+					{
+						const auto pair = source.substr(pos, 2);
+						pos += std::find(TwoCharPunctuators.begin(), TwoCharPunctuators.end(), pair) != TwoCharPunctuators.end() ? 2 : 1;
+					}
+
+					tokens.push_back({kind, source.substr(begin, pos - begin), spaced});
+					spaced = false;
+				}
+
+				return true;
+			}
+
+		private:
+			std::string_view source;
+			std::size_t pos = 0;
+		};
+
+		// Evaluates the integer expression of an #if once macros are expanded, unknown identifiers are 0.
+		class ExpressionParser
+		{
+		public:
+			explicit ExpressionParser(const Tokens& tokens_)
+				: tokens(tokens_)
+			{
+			}
+
+			long long Parse()
+			{
+				const auto condition = ParseBinary(1);
+
+				if (!Accept("?"))
+					return condition;
+
+				const auto then = Parse();
+				Accept(":");
+				const auto otherwise = Parse();
+				return condition != 0 ? then : otherwise;
+			}
+
+		private:
+			const Tokens& tokens;
+			std::size_t pos = 0;
+
+			bool Accept(std::string_view punctuator)
+			{
+				if (pos >= tokens.size() || !tokens[pos].Is(punctuator))
+					return false;
+
+				++pos;
+				return true;
+			}
+
+			static int GetPrecedence(const Token& token)
+			{
+				constexpr auto Operators = std::array<std::pair<std::string_view, int>, 18>{{
+					{"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5}, {"==", 6}, {"!=", 6},
+					{"<", 7}, {">", 7}, {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8},
+					{"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10},
+				}};
+
+				if (token.kind != TokenKind::Punctuator)
+					return 0;
+
+				const auto found = std::find_if(Operators.begin(), Operators.end(), [&](const auto& op) { return op.first == token.text; });
+				return found != Operators.end() ? found->second : 0;
+			}
+
+			// Wraps around on overflow like the target compiler instead of leaving it undefined.
+			static long long Wrap(unsigned long long value)
+			{
+				return static_cast<long long>(value);
+			}
+
+			static long long Apply(std::string_view op, long long lhs, long long rhs)
+			{
+				const auto ulhs = static_cast<unsigned long long>(lhs);
+				const auto urhs = static_cast<unsigned long long>(rhs);
+
+				if (op == "||") return lhs != 0 || rhs != 0;
+				if (op == "&&") return lhs != 0 && rhs != 0;
+				if (op == "|") return lhs | rhs;
+				if (op == "^") return lhs ^ rhs;
+				if (op == "&") return lhs & rhs;
+				if (op == "==") return lhs == rhs;
+				if (op == "!=") return lhs != rhs;
+				if (op == "<") return lhs < rhs;
+				if (op == ">") return lhs > rhs;
+				if (op == "<=") return lhs <= rhs;
+				if (op == ">=") return lhs >= rhs;
+				if (op == "<<") return Wrap(ulhs << (rhs & 63));
+				if (op == ">>") return lhs >> (rhs & 63);
+				if (op == "+") return Wrap(ulhs + urhs);
+				if (op == "-") return Wrap(ulhs - urhs);
+				if (op == "*") return Wrap(ulhs * urhs);
+				if (rhs == 0) return 0;
+				// LLONG_MIN / -1 overflows and traps on x86.
+				if (rhs == -1) return op == "/" ? Wrap(0 - ulhs) : 0;
+				return op == "/" ? lhs / rhs : lhs % rhs;
+			}
+
+			long long ParseBinary(int minPrecedence)
+			{
+				auto lhs = ParseUnary();
+
+				while (pos < tokens.size())
+				{
+					const auto& op = tokens[pos];
+					const auto precedence = GetPrecedence(op);
+
+					if (precedence < minPrecedence || precedence == 0)
+						break;
+
+					++pos;
+					lhs = Apply(op.text, lhs, ParseBinary(precedence + 1));
+				}
+
+				return lhs;
+			}
+
+			long long ParseUnary()
+			{
+				if (pos >= tokens.size())
+					return 0;
+				if (Accept("!"))
+					return ParseUnary() == 0;
+				if (Accept("-"))
+					return Wrap(0 - static_cast<unsigned long long>(ParseUnary()));
+				if (Accept("+"))
+					return ParseUnary();
+				if (Accept("~"))
+					return ~ParseUnary();
+
+				if (Accept("("))
+				{
+					const auto value = Parse();
+					Accept(")");
+					return value;
+				}
+
+				const auto& token = tokens[pos++];
+				return token.kind == TokenKind::Number ? std::strtoll(std::string{token.text}.c_str(), nullptr, 0) : 0;
+			}
+		};
+
+		struct Conditional
+		{
+			bool parentActive;
+			// Whether a branch of the block was already taken.
+			bool taken;
+			bool active;
+		};
+
+		// Produces the tokens the compiler would see, without #include support.
+		class Preprocessor
+		{
+		public:
+			Tokens output;
+
+			void DefineFromOptions(const std::string& options)
+			{
+				auto words = std::vector<std::string>{};
+				auto word = std::string{};
+
+				for (const auto c : options + ' ')
+				{
+					if (!std::isspace(static_cast<unsigned char>(c)))
+						word += c;
+					else if (!word.empty())
+						words.push_back(std::exchange(word, {}));
+				}
+
+				for (auto i = std::size_t{0}; i < words.size(); ++i)
+				{
+					if (words[i].rfind("-D", 0) != 0)
+						continue;
+
+					auto definition = words[i].substr(2);
+
+					if (definition.empty() && i + 1 < words.size())
+						definition = words[++i];
+
+					const auto equals = definition.find('=');
+					const auto name = definition.substr(0, equals);
+
+					auto line = Tokens{};
+					Lexer{equals == std::string::npos ? std::string_view{"1"} : Store(definition.substr(equals + 1))}.NextLine(line);
+
+					if (!name.empty())
+						macros[Store(name)] = Macro{false, false, {}, std::move(line)};
+				}
+			}
+
+			void Run(std::string_view source)
+			{
+				auto lexer = Lexer{source};
+				auto line = Tokens{};
+				auto pending = Tokens{};
+
+				while (lexer.NextLine(line))
+				{
+					if (!line.empty() && line.front().Is("#"))
+					{
+						// Macros apply from their definition on, so the code before the directive is expanded first.
+						Flush(pending);
+						RunDirective(line);
+					}
+					else if (IsActive())
+					{
+						pending.insert(pending.end(), std::make_move_iterator(line.begin()), std::make_move_iterator(line.end()));
+					}
+				}
+
+				Flush(pending);
+			}
+
+		private:
+			// Keys and tokens point into the source or the storage.
+			std::unordered_map<std::string_view, Macro> macros;
+			std::vector<Conditional> conditionals;
+			std::unordered_set<std::string_view> disabled;
+			// Text of pasted tokens and -D options. Deque elements never move.
+			std::deque<std::string> storage;
+
+			std::string_view Store(std::string text) { return storage.emplace_back(std::move(text)); }
+
+			bool IsActive() const { return conditionals.empty() || conditionals.back().active; }
+
+			void Flush(Tokens& pending)
+			{
+				Expand(pending, output);
+				pending.clear();
+			}
+
+			void RunDirective(const Tokens& line)
+			{
+				if (line.size() < 2)
+					return;
+
+				const auto& name = line[1].text;
+
+				if (name == "ifdef" || name == "ifndef")
+				{
+					const auto defined = line.size() > 2 && macros.contains(line[2].text);
+					PushConditional(name == "ifdef" ? defined : !defined);
+				}
+				else if (name == "if")
+				{
+					PushConditional(IsActive() && Evaluate(line));
+				}
+				else if (name == "elif" && !conditionals.empty())
+				{
+					auto& conditional = conditionals.back();
+					conditional.active = !conditional.taken && conditional.parentActive && Evaluate(line);
+					conditional.taken = conditional.taken || conditional.active;
+				}
+				else if (name == "else" && !conditionals.empty())
+				{
+					auto& conditional = conditionals.back();
+					conditional.active = !conditional.taken && conditional.parentActive;
+					conditional.taken = true;
+				}
+				else if (name == "endif" && !conditionals.empty())
+				{
+					conditionals.pop_back();
+				}
+				else if (IsActive() && name == "define" && line.size() > 2)
+				{
+					Define(line);
+				}
+				else if (IsActive() && name == "undef" && line.size() > 2)
+				{
+					macros.erase(line[2].text);
+				}
+			}
+
+			void PushConditional(bool condition)
+			{
+				const auto active = IsActive() && condition;
+				conditionals.push_back({IsActive(), active, active});
+			}
+
+			void Define(const Tokens& line)
+			{
+				auto macro = Macro{};
+				auto body = std::size_t{3};
+
+				if (line.size() > 3 && line[3].Is("(") && !line[3].spaced)
+				{
+					macro.isFunction = true;
+
+					for (body = 4; body < line.size() && !line[body].Is(")"); ++body)
+					{
+						if (line[body].kind == TokenKind::Identifier)
+							macro.params.push_back(line[body].text);
+						else if (line[body].Is("..."))
+						{
+							macro.params.push_back("__VA_ARGS__");
+							macro.isVariadic = true;
+						}
+					}
+
+					++body;
+				}
+
+				if (body < line.size())
+					macro.body.assign(line.begin() + body, line.end());
+
+				macros[line[2].text] = std::move(macro);
+			}
+
+			bool Evaluate(const Tokens& line)
+			{
+				auto tokens = Tokens{};
+
+				// `defined` is resolved before expansion, so that the macros it names are not expanded.
+				for (auto i = std::size_t{2}; i < line.size(); ++i)
+				{
+					if (line[i].text != "defined")
+					{
+						tokens.push_back(line[i]);
+						continue;
+					}
+
+					const auto parenthesized = i + 1 < line.size() && line[i + 1].Is("(");
+					const auto nameIndex = i + (parenthesized ? 2 : 1);
+					const auto defined = nameIndex < line.size() && macros.contains(line[nameIndex].text);
+
+					tokens.push_back({TokenKind::Number, defined ? "1" : "0"});
+					i = nameIndex + (parenthesized ? 1 : 0);
+				}
+
+				auto expanded = Tokens{};
+				Expand(tokens, expanded);
+				return ExpressionParser{expanded}.Parse() != 0;
+			}
+
+			// Returns the index of the closing parenthesis, 0 when the macro is not invoked.
+			static std::size_t CollectArgs(const Tokens& input, std::size_t start, std::vector<Tokens>& args)
+			{
+				if (start >= input.size() || !input[start].Is("("))
+					return 0;
+
+				auto depth = 0;
+				args.emplace_back();
+
+				for (auto i = start + 1; i < input.size(); ++i)
+				{
+					const auto& token = input[i];
+
+					if (token.Is(")") && depth-- == 0)
+						return i;
+
+					if (token.Is("("))
+						++depth;
+
+					if (token.Is(",") && depth == 0)
+						args.emplace_back();
+					else
+						args.back().push_back(token);
+				}
+
+				return 0;
+			}
+
+			Tokens Substitute(const Macro& macro, const std::vector<Tokens>& args)
+			{
+				const auto getParam = [&](const Token& token) -> const Tokens*
+				{
+					const auto found = std::find(macro.params.begin(), macro.params.end(), token.text);
+					const auto index = static_cast<std::size_t>(found - macro.params.begin());
+					return token.kind == TokenKind::Identifier && index < args.size() ? &args[index] : nullptr;
+				};
+
+				auto substituted = Tokens{};
+				const auto& body = macro.body;
+
+				for (auto i = std::size_t{0}; i < body.size(); ++i)
+				{
+					const auto param = getParam(body[i]);
+
+					if (body[i].Is("#") && i + 1 < body.size() && getParam(body[i + 1]) != nullptr)
+					{
+						substituted.push_back({TokenKind::String, "\"\""});
+						++i;
+					}
+					else if (param == nullptr)
+					{
+						substituted.push_back(body[i]);
+					}
+					else if ((i > 0 && body[i - 1].Is("##")) || (i + 1 < body.size() && body[i + 1].Is("##")))
+					{
+						// Operands of ## are pasted as written.
+						substituted.insert(substituted.end(), param->begin(), param->end());
+					}
+					else
+					{
+						// A parameter can be used more than once.
+						auto arg = *param;
+						Expand(arg, substituted);
+					}
+				}
+
+				auto pasted = Tokens{};
+
+				for (auto i = std::size_t{0}; i < substituted.size(); ++i)
+				{
+					if (substituted[i].Is("##") && !pasted.empty() && i + 1 < substituted.size())
+					{
+						pasted.back().text = Store(std::string{pasted.back().text} + std::string{substituted[++i].text});
+						pasted.back().kind = GetKind(pasted.back().text);
+					}
+					else
+					{
+						pasted.push_back(std::move(substituted[i]));
+					}
+				}
+
+				return pasted;
+			}
+
+			// Consumes the input, tokens which are not macros are moved to the output.
+			void Expand(Tokens& input, Tokens& out)
+			{
+				for (auto i = std::size_t{0}; i < input.size(); ++i)
+				{
+					auto& token = input[i];
+					const auto found = token.kind == TokenKind::Identifier && !macros.empty() ? macros.find(token.text) : macros.end();
+
+					if (found == macros.end() || disabled.contains(token.text))
+					{
+						out.push_back(std::move(token));
+						continue;
+					}
+
+					const auto& macro = found->second;
+					auto replacement = Tokens{};
+
+					if (macro.isFunction)
+					{
+						auto args = std::vector<Tokens>{};
+						const auto end = CollectArgs(input, i + 1, args);
+
+						if (end == 0)
+						{
+							out.push_back(token);
+							continue;
+						}
+
+						// Arguments past the named parameters are joined back with their commas, __VA_ARGS__ may also be empty.
+						if (macro.isVariadic)
+						{
+							for (auto j = macro.params.size(); j < args.size(); ++j)
+							{
+								auto& rest = args[macro.params.size() - 1];
+								rest.push_back({TokenKind::Punctuator, ","});
+								rest.insert(rest.end(), args[j].begin(), args[j].end());
+							}
+
+							args.resize(macro.params.size());
+						}
+
+						replacement = Substitute(macro, args);
+						i = end;
+					}
+					else
+					{
+						replacement = macro.body;
+					}
+
+					// A macro is not expanded again inside its own expansion.
+					disabled.insert(token.text);
+					Expand(replacement, out);
+					disabled.erase(token.text);
+				}
+			}
+		};
+
+		bool IsOneOf(std::string_view text, std::initializer_list<std::string_view> values)
+		{
+			return std::find(values.begin(), values.end(), text) != values.end();
+		}
+
+		std::size_t GetTypeSize(const std::string& type)
+		{
+			constexpr auto Scalars = std::array<std::pair<std::string_view, std::size_t>, 11>{{
+				{"char", 1}, {"uchar", 1}, {"short", 2}, {"ushort", 2}, {"half", 2}, {"int", 4},
+				{"uint", 4}, {"float", 4}, {"long", 8}, {"ulong", 8}, {"double", 8},
+			}};
+
+			if (IsOneOf(type, {"size_t", "ptrdiff_t", "intptr_t", "uintptr_t"}))
+				return sizeof(cl_ulong);
+			if (type == "sampler_t")
+				return sizeof(cl_sampler);
+			if (type.rfind("image", 0) == 0 || type.rfind("pipe", 0) == 0)
+				return sizeof(cl_mem);
+
+			const auto digits = type.find_last_not_of("0123456789") + 1;
+			const auto base = std::string_view{type}.substr(0, digits);
+			const auto width = digits < type.size() ? std::atoi(type.c_str() + digits) : 1;
+			const auto scalar = std::find_if(Scalars.begin(), Scalars.end(), [&](const auto& entry) { return entry.first == base; });
+
+			if (scalar == Scalars.end() || (width != 1 && width != 2 && width != 3 && width != 4 && width != 8 && width != 16))
+				return 0;
+
+			// Three component vectors take the space of four.
+			return scalar->second * (width == 3 ? 4 : width);
+		}
+
+		std::string GetTypeName(std::vector<std::string> words)
+		{
+			if (!words.empty() && words.front() == "signed")
+				words.erase(words.begin());
+
+			if (!words.empty() && words.front() == "unsigned")
+				return words.size() > 1 ? "u" + words[1] : "uint";
+
+			auto name = std::string{};
+
+			for (const auto& word : words)
+				name += (name.empty() ? "" : " ") + word;
+
+			return name;
+		}
+
+		// Returns the index after the closing parenthesis of the group starting at `start`.
+		std::size_t SkipParentheses(const Tokens& tokens, std::size_t start)
+		{
+			auto depth = 0;
+
+			for (auto i = start; i < tokens.size(); ++i)
+			{
+				if (tokens[i].Is("("))
+					++depth;
+				else if (tokens[i].Is(")") && --depth <= 0)
+					return i + 1;
+			}
+
+			return tokens.size();
+		}
+
+		std::optional<KernelArgSignature> ParseArg(const Tokens& tokens, std::size_t begin, std::size_t end)
+		{
+			auto arg = KernelArgSignature{};
+			auto words = std::vector<std::string>{};
+			auto pointers = 0;
+
+			for (auto i = begin; i < end; ++i)
+			{
+				const auto text = tokens[i].text;
+
+				if (text == "__attribute__" || text == "__attribute")
+				{
+					i = SkipParentheses(tokens, i + 1) - 1;
+				}
+				else if (tokens[i].Is("[") || tokens[i].Is("*"))
+				{
+					// Array parameters are pointers.
+					if (tokens[i].Is("["))
+					{
+						while (i + 1 < end && !tokens[i].Is("]"))
+							++i;
+					}
+
+					++pointers;
+				}
+				else if (tokens[i].kind != TokenKind::Identifier)
+				{
+				}
+				else if (IsOneOf(text, {"__global", "global"}))
+					arg.addressQualifier = CL_KERNEL_ARG_ADDRESS_GLOBAL;
+				else if (IsOneOf(text, {"__constant", "constant"}))
+					arg.addressQualifier = CL_KERNEL_ARG_ADDRESS_CONSTANT;
+				else if (IsOneOf(text, {"__local", "local"}))
+					arg.addressQualifier = CL_KERNEL_ARG_ADDRESS_LOCAL;
+				else if (IsOneOf(text, {"__private", "private"}))
+					arg.addressQualifier = CL_KERNEL_ARG_ADDRESS_PRIVATE;
+				else if (IsOneOf(text, {"__read_only", "read_only"}))
+					arg.accessQualifier = CL_KERNEL_ARG_ACCESS_READ_ONLY;
+				else if (IsOneOf(text, {"__write_only", "write_only"}))
+					arg.accessQualifier = CL_KERNEL_ARG_ACCESS_WRITE_ONLY;
+				else if (IsOneOf(text, {"__read_write", "read_write"}))
+					arg.accessQualifier = CL_KERNEL_ARG_ACCESS_READ_WRITE;
+				else if (IsOneOf(text, {"restrict", "__restrict", "__restrict__"}))
+					arg.typeQualifier |= CL_KERNEL_ARG_TYPE_RESTRICT;
+				// Qualifiers after the '*' apply to the pointer itself and are not reported.
+				else if (text == "const")
+					arg.typeQualifier |= pointers == 0 ? CL_KERNEL_ARG_TYPE_CONST : 0;
+				else if (text == "volatile")
+					arg.typeQualifier |= pointers == 0 ? CL_KERNEL_ARG_TYPE_VOLATILE : 0;
+				else if (text == "pipe")
+					arg.typeQualifier |= CL_KERNEL_ARG_TYPE_PIPE;
+				else
+					words.emplace_back(text);
+			}
+
+			if (words.empty() || (words.size() == 1 && words.front() == "void" && pointers == 0))
+				return std::nullopt;
+
+			if (words.size() > 1)
+			{
+				arg.name = std::move(words.back());
+				words.pop_back();
+			}
+
+			const auto type = GetTypeName(std::move(words));
+			const auto isImage = type.rfind("image", 0) == 0;
+
+			arg.typeName = type + std::string(pointers, '*');
+			arg.isPointer = pointers > 0;
+
+			if (arg.addressQualifier == CL_KERNEL_ARG_ADDRESS_CONSTANT)
+				arg.typeQualifier |= CL_KERNEL_ARG_TYPE_CONST;
+
+			if (isImage || (arg.typeQualifier & CL_KERNEL_ARG_TYPE_PIPE) != 0)
+				arg.addressQualifier = CL_KERNEL_ARG_ADDRESS_GLOBAL;
+			if (isImage && arg.accessQualifier == CL_KERNEL_ARG_ACCESS_NONE)
+				arg.accessQualifier = CL_KERNEL_ARG_ACCESS_READ_ONLY;
+
+			if (arg.IsLocal())
+				arg.size = 0;
+			else if (arg.isPointer || (arg.typeQualifier & CL_KERNEL_ARG_TYPE_PIPE) != 0)
+				arg.size = sizeof(cl_mem);
+			else
+				arg.size = GetTypeSize(type);
+
+			return arg;
+		}
+
+		// Parses the declaration following a kernel qualifier, returns the index of the last token used.
+		std::size_t ParseKernel(const Tokens& tokens, std::size_t start, std::vector<KernelSignature>& kernels)
+		{
+			auto i = start;
+			auto name = std::string{};
+
+			for (; i < tokens.size() && !tokens[i].Is("(") && !tokens[i].Is(";") && !tokens[i].Is("{"); ++i)
+			{
+				if (tokens[i].text == "__attribute__" || tokens[i].text == "__attribute")
+					i = SkipParentheses(tokens, i + 1) - 1;
+				else if (tokens[i].kind == TokenKind::Identifier)
+					name = std::string{tokens[i].text};
+			}
+
+			if (i >= tokens.size() || !tokens[i].Is("(") || name.empty())
+				return i - 1;
+
+			auto kernel = KernelSignature{name, {}};
+			const auto end = SkipParentheses(tokens, i) - 1;
+			auto argBegin = i + 1;
+			auto depth = 0;
+
+			for (auto j = i + 1; j <= end && j < tokens.size(); ++j)
+			{
+				if (tokens[j].Is("("))
+					++depth;
+				else if (tokens[j].Is(")") && j != end)
+					--depth;
+				else if ((tokens[j].Is(",") && depth == 0) || j == end)
+				{
+					if (auto arg = ParseArg(tokens, argBegin, j))
+						kernel.args.push_back(std::move(*arg));
+					argBegin = j + 1;
+				}
+			}
+
+			kernels.push_back(std::move(kernel));
+			return end;
+		}
+	}
+
+	std::shared_ptr<const KernelTable> KernelTable::Get(const InternedText& source, const std::string& options)
+	{
+		struct Cache
+		{
+			std::mutex mutex;
+			std::unordered_map<std::uint64_t, std::weak_ptr<const KernelTable>> tables;
+			std::size_t sweepSize = 64;
+		};
+
+		static auto cache = Cache{};
+
+		const auto key = Hash64(options.data(), options.size(), source.GetHash());
+
+		{
+			auto lock = std::lock_guard{cache.mutex};
+
+			if (auto table = cache.tables[key].lock())
+				return table;
+		}
+
+		// Scanned without the lock, concurrent builds of the same source may scan it twice.
+		auto table = std::make_shared<const KernelTable>(Scan(source.GetView(), options));
+
+		auto lock = std::lock_guard{cache.mutex};
+		cache.tables[key] = table;
+
+		if (cache.tables.size() >= cache.sweepSize)
+		{
+			std::erase_if(cache.tables, [](const auto& entry) { return entry.second.expired(); });
+			cache.sweepSize = std::max<std::size_t>(cache.tables.size() * 2, 64);
+		}
+
+		return table;
+	}
+
+	const KernelSignature* KernelTable::Find(const std::string& name) const
+	{
+		const auto found = indices.find(name);
+		return found != indices.end() ? &kernels[found->second] : nullptr;
+	}
+
+	std::string KernelTable::GetNames() const
+	{
+		auto names = std::string{};
+
+		for (const auto& kernel : kernels)
+			names += (names.empty() ? "" : ";") + kernel.name;
+
+		return names;
+	}
+
+	KernelTable KernelTable::Scan(std::string_view source, const std::string& options)
+	{
+		auto preprocessor = Preprocessor{};
+		preprocessor.DefineFromOptions(options);
+		preprocessor.Run(source);
+
+		const auto& tokens = preprocessor.output;
+		auto table = KernelTable{};
+		auto depth = 0;
+
+		for (auto i = std::size_t{0}; i < tokens.size(); ++i)
+		{
+			const auto& token = tokens[i];
+
+			if (token.Is("{"))
+				++depth;
+			else if (token.Is("}"))
+				depth = std::max(depth - 1, 0);
+			else if (depth == 0 && token.kind == TokenKind::Identifier && (token.text == "__kernel" || token.text == "kernel"))
+				i = ParseKernel(tokens, i + 1, table.kernels);
+		}
+
+		// Prototypes and definitions of the same kernel are listed once.
+		auto unique = std::vector<KernelSignature>{};
+
+		for (auto& kernel : table.kernels)
+		{
+			if (table.indices.emplace(kernel.name, unique.size()).second)
+				unique.push_back(std::move(kernel));
+		}
+
+		table.kernels = std::move(unique);
+		return table;
+	}
+
+}
@@ -0,0 +1,131 @@
+#include <OpenCLMocker/MemoryCopy.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+#include <OpenCLMocker/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		// Multiple of every valid pattern size and small enough to stay in the cache while it is copied.
+		constexpr std::size_t FillBlockSize = 64 * 1024;
+		// Smaller pieces of a parallel transfer cost more to schedule than they gain.
+		constexpr std::size_t MinChunkSize = 1024 * 1024;
+		constexpr std::size_t ChunksPerThread = 4;
+
+		// Returns the size of the pieces the transfer is split into on the thread pool, 0 when it stays on the calling thread.
+		std::size_t GetChunkSize(std::size_t size, std::size_t alignment)
+		{
+			const auto threshold = Config::GetInstance().parallelCopyThreshold;
+
+			if (threshold == 0 || size < threshold)
+				return 0;
+
+			const auto chunk = std::max(size / (ThreadPool::GetInstance().GetThreadCount() * ChunksPerThread), MinChunkSize);
+			return (chunk + alignment - 1) / alignment * alignment;
+		}
+
+		void FillSerial(char* out, std::size_t size, const void* pattern, std::size_t patternSize)
+		{
+			// Doubles the filled prefix until it is a block, then repeats the block, so that every memcpy is wide.
+			std::memcpy(out, pattern, patternSize);
+
+			for (auto filled = patternSize; filled < size;)
+			{
+				const auto length = std::min({filled, FillBlockSize, size - filled});
+				std::memcpy(out + filled, out, length);
+				filled += length;
+			}
+		}
+	}
+
+	void CopyBytes(void* dst, const void* src, std::size_t size)
+	{
+		const auto chunk = GetChunkSize(size, 4096);
+
+		if (chunk == 0)
+		{
+			std::memcpy(dst, src, size);
+			return;
+		}
+
+		ThreadPool::GetInstance().ParallelFor(size, chunk, [&](std::size_t begin, std::size_t end)
+			{
+				std::memcpy(static_cast<char*>(dst) + begin, static_cast<const char*>(src) + begin, end - begin);
+			});
+	}
+
+	void FillPattern(void* dst, std::size_t size, const void* pattern, std::size_t patternSize)
+	{
+		const auto out = static_cast<char*>(dst);
+		const auto bytes = static_cast<const char*>(pattern);
+
+		if (size == 0)
+			return;
+
+		// Covers byte patterns and the common zero fill of wider types.
+		const auto uniform = std::all_of(bytes, bytes + patternSize, [&](char byte) { return byte == bytes[0]; });
+
+		// Chunks start at multiples of the block, which keeps the pattern aligned in every one of them.
+		const auto fill = [&](std::size_t begin, std::size_t end)
+		{
+			if (uniform)
+				std::memset(out + begin, bytes[0], end - begin);
+			else
+				FillSerial(out + begin, end - begin, pattern, patternSize);
+		};
+
+		const auto chunk = GetChunkSize(size, FillBlockSize);
+
+		if (chunk == 0)
+			fill(0, size);
+		else
+			ThreadPool::GetInstance().ParallelFor(size, chunk, fill);
+	}
+
+	void CopyRect(char* dst, const RectLayout& dstLayout, const char* src, const RectLayout& srcLayout, const Region& region)
+	{
+		dst += dstLayout.GetOffset();
+		src += srcLayout.GetOffset();
+
+		if (dst == src && dstLayout.rowPitch == srcLayout.rowPitch && dstLayout.slicePitch == srcLayout.slicePitch)
+			return;
+
+		const auto rowsContiguous = dstLayout.rowPitch == region[0] && srcLayout.rowPitch == region[0];
+		const auto sliceSize = region[0] * region[1];
+
+		if (rowsContiguous && dstLayout.slicePitch == sliceSize && srcLayout.slicePitch == sliceSize)
+		{
+			CopyBytes(dst, src, sliceSize * region[2]);
+			return;
+		}
+
+		// Contiguous rows of a slice are copied as a single unit.
+		const auto rowsPerUnit = rowsContiguous ? region[1] : 1;
+		const auto unitSize = region[0] * rowsPerUnit;
+		const auto unitsPerSlice = region[1] / rowsPerUnit;
+		const auto unitCount = unitsPerSlice * region[2];
+
+		const auto copyUnits = [&](std::size_t begin, std::size_t end)
+		{
+			for (auto unit = begin; unit < end; ++unit)
+			{
+				const auto z = unit / unitsPerSlice;
+				const auto y = unit % unitsPerSlice * rowsPerUnit;
+				std::memcpy(dst + z * dstLayout.slicePitch + y * dstLayout.rowPitch, src + z * srcLayout.slicePitch + y * srcLayout.rowPitch, unitSize);
+			}
+		};
+
+		const auto chunk = GetChunkSize(unitSize * unitCount, 1);
+
+		if (chunk == 0)
+			copyUnits(0, unitCount);
+		else
+			ThreadPool::GetInstance().ParallelFor(unitCount, std::max<std::size_t>(chunk / unitSize, 1), copyUnits);
+	}
+
+}
@@ -0,0 +1,94 @@
+#include <OpenCLMocker/MemoryPool.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+
+#include <bit>
+
+namespace OpenCL
+{
+
+	MemoryPool::MemoryPool()
+		: MemoryPool(Config::GetInstance().bufferPoolLimit)
+	{
+	}
+
+	MemoryPool::MemoryPool(std::size_t limit_)
+		: limit(limit_)
+	{
+	}
+
+	DeviceMemory MemoryPool::Acquire(std::size_t size)
+	{
+		const auto index = GetSizeClass(size);
+
+		if (limit != 0)
+		{
+			auto& sizeClass = classes[index];
+			auto lock = std::lock_guard{sizeClass.mutex};
+
+			if (!sizeClass.blocks.empty())
+			{
+				auto memory = std::move(sizeClass.blocks.back());
+				sizeClass.blocks.pop_back();
+
+				++hits;
+				cachedBytes -= memory.GetSize();
+				--cachedBlocks;
+				return memory;
+			}
+		}
+
+		++misses;
+		return DeviceMemory{size};
+	}
+
+	void MemoryPool::Recycle(DeviceMemory memory)
+	{
+		auto size = memory.GetSize();
+
+		if (memory.Get() == nullptr || size > limit)
+			return;
+
+		const auto index = GetSizeClass(size);
+
+		if (size != memory.GetSize())
+			return;
+
+		if (cachedBytes.fetch_add(size) + size > limit)
+		{
+			cachedBytes -= size;
+			return;
+		}
+
+		// Large cached blocks keep their address range but give the pages back.
+		memory.Discard();
+
+		auto& sizeClass = classes[index];
+		auto lock = std::lock_guard{sizeClass.mutex};
+		sizeClass.blocks.emplace_back(std::move(memory));
+		++cachedBlocks;
+	}
+
+	MemoryPool::Statistics MemoryPool::GetStatistics() const
+	{
+		return Statistics{hits, misses, cachedBytes, cachedBlocks};
+	}
+
+	std::size_t MemoryPool::GetSizeClass(std::size_t& size)
+	{
+		if (size <= MinClassSize)
+		{
+			size = MinClassSize;
+			return 0;
+		}
+
+		// 2^power < size <= 2^(power + 1), split into StepsPerDoubling classes.
+		const auto power = static_cast<std::size_t>(std::bit_width(size - 1) - 1);
+		const auto step = std::size_t{1} << (power - 2);
+		const auto steps = (size + step - 1) / step;
+
+		size = steps * step;
+		return (power - 8) * StepsPerDoubling + (steps - StepsPerDoubling);
+	}
+
+}
@@ -0,0 +1,185 @@
+#include <OpenCLMocker/NativeKernels.hpp>
+
+#include <OpenCLMocker/Buffer.hpp>
+#include <OpenCLMocker/Config.hpp>
+#include <OpenCLMocker/Exception.hpp>
+#include <OpenCLMocker/Kernel.hpp>
+#include <OpenCLMocker/Retained.hpp>
+#include <OpenCLMocker/ThreadPool.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		struct Launch
+		{
+			Native::KernelFunction function;
+			std::string name;
+			// Snapshot taken at enqueue, later clSetKernelArg calls do not change it.
+			KernelArgs args;
+			std::vector<Retained<Buffer>> buffers;
+			Native::WorkGroup range;
+			std::size_t groupCount;
+
+			void Run(std::size_t begin, std::size_t end) const
+			{
+				auto nativeArgs = std::vector<Native::KernelArg>(args.GetCount());
+				auto localMemory = std::vector<std::unique_ptr<std::max_align_t[]>>{};
+
+				for (auto i = std::size_t{0}; i < args.GetCount(); ++i)
+				{
+					auto& nativeArg = nativeArgs[i];
+					const auto size = args.GetSize(i);
+
+					if (args.IsLocal(i))
+					{
+						const auto count = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+						localMemory.emplace_back(std::make_unique<std::max_align_t[]>(count));
+						nativeArg = {nullptr, size, localMemory.back().get()};
+					}
+					else
+					{
+						nativeArg = {args.GetValue(i), size, buffers[i] ? buffers[i]->start : nullptr};
+					}
+				}
+
+				auto group = range;
+
+				for (auto index = begin; index < end; ++index)
+				{
+					auto rest = index;
+
+					for (auto d = cl_uint{0}; d < 3; ++d)
+					{
+						group.groupId[d] = rest % range.numGroups[d];
+						rest /= range.numGroups[d];
+
+						const auto base = group.groupId[d] * range.enqueuedLocalSize[d];
+						group.localSize[d] = std::min(range.enqueuedLocalSize[d], range.globalSize[d] - base);
+					}
+
+					function(nativeArgs.data(), nativeArgs.size(), group);
+				}
+			}
+
+			void operator()() const
+			{
+				auto& pool = ThreadPool::GetInstance();
+				const auto grain = groupCount / (pool.GetThreadCount() * 8);
+
+				pool.ParallelFor(groupCount, grain, [this](std::size_t begin, std::size_t end) { Run(begin, end); });
+
+				for (const auto& buffer : buffers)
+				{
+					if (buffer && !buffer->GetMemFlags().HasFlags(CL_MEM_READ_ONLY))
+						buffer->Dump("kernel-" + name);
+				}
+			}
+		};
+	}
+
+	NativeKernels::NativeKernels()
+	{
+		for (const auto& path : Config::GetInstance().kernelPlugins)
+			Load(path.string());
+	}
+
+	NativeKernels& NativeKernels::GetInstance()
+	{
+		static auto instance = NativeKernels{};
+		return instance;
+	}
+
+	Native::KernelFunction NativeKernels::Find(const std::string& name) const
+	{
+		const auto found = kernels.find(name);
+		return found != kernels.end() ? found->second : nullptr;
+	}
+
+	void NativeKernels::Register(const char* name, Native::KernelFunction function)
+	{
+		if (name == nullptr || function == nullptr)
+			return;
+
+		kernels[name] = function;
+	}
+
+	std::function<void()> NativeKernels::Prepare(const Kernel& kernel, const std::vector<size_t>& global_work_offset, const std::vector<size_t>& global_work_size, const std::vector<size_t>& local_work_size) const
+	{
+		const auto function = Find(kernel.name);
+
+		if (function == nullptr)
+			return {};
+
+		auto launch = std::make_shared<Launch>();
+		launch->function = function;
+		launch->name = kernel.name;
+
+		auto& args = launch->args;
+		args = kernel.GetArgs();
+		launch->buffers.reserve(args.GetCount());
+
+		for (auto i = std::size_t{0}; i < args.GetCount(); ++i)
+		{
+			if (!args.IsSet(i))
+				throw Exception{CL_INVALID_KERNEL_ARGS, "Argument " + std::to_string(i) + " of kernel " + kernel.name + " is not set."};
+
+			launch->buffers.emplace_back(Buffer::FindByValue(args.GetValue(i), args.GetSize(i)));
+		}
+
+		auto& range = launch->range;
+		range.dimensions = static_cast<cl_uint>(global_work_size.size());
+		launch->groupCount = 1;
+
+		for (auto d = std::size_t{0}; d < 3; ++d)
+		{
+			const auto used = d < global_work_size.size();
+			const auto local = used && !local_work_size.empty() ? local_work_size[d] : d == 0 ? 64 : 1;
+
+			if (local == 0)
+				throw Exception{CL_INVALID_WORK_GROUP_SIZE};
+
+			range.groupId[d] = 0;
+			range.globalOffset[d] = used ? global_work_offset[d] : 0;
+			range.globalSize[d] = used ? global_work_size[d] : 1;
+			range.enqueuedLocalSize[d] = std::min(local, std::max<std::size_t>(range.globalSize[d], 1));
+			range.localSize[d] = range.enqueuedLocalSize[d];
+			range.numGroups[d] = (range.globalSize[d] + range.enqueuedLocalSize[d] - 1) / range.enqueuedLocalSize[d];
+			launch->groupCount *= range.numGroups[d];
+		}
+
+		return [launch = std::shared_ptr<const Launch>{std::move(launch)}]() { (*launch)(); };
+	}
+
+	void NativeKernels::Load(const std::string& path)
+	{
+#ifdef _WIN32
+		const auto library = LoadLibraryA(path.c_str());
+		const auto symbol = library != nullptr ? reinterpret_cast<void*>(GetProcAddress(library, Native::RegisterKernelsSymbol)) : nullptr;
+#else
+		const auto library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+		const auto symbol = library != nullptr ? dlsym(library, Native::RegisterKernelsSymbol) : nullptr;
+#endif
+
+		if (symbol == nullptr)
+		{
+			std::cerr << "Failed to load kernel plugin " << path << "." << std::endl;
+			return;
+		}
+
+		// Plugins stay loaded until exit, the registered functions point into them.
+		reinterpret_cast<Native::RegisterKernelsFunction>(symbol)(*this);
+	}
+
+}
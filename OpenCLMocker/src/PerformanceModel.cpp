@@ -0,0 +1,82 @@
+#include <OpenCLMocker/PerformanceModel.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+
+#include <chrono>
+
+namespace OpenCL
+{
+
+	static DeviceClock::Duration ToDuration(double nanoseconds)
+	{
+		return std::chrono::duration_cast<DeviceClock::Duration>(std::chrono::duration<double, std::nano>{nanoseconds});
+	}
+
+	PerformanceModel::PerformanceModel()
+		: PerformanceModel(PerformanceConfig{})
+	{
+	}
+
+	PerformanceModel::PerformanceModel(const PerformanceConfig& cfg)
+		: hostToDeviceBandwidth(cfg.hostToDeviceBandwidth)
+		, deviceToHostBandwidth(cfg.deviceToHostBandwidth)
+		, deviceToDeviceBandwidth(cfg.deviceToDeviceBandwidth)
+		, copyLatency(cfg.copyLatency)
+		, cachedBuildLatency(cfg.cachedBuildLatency)
+		, defaultKernelCost{0, cfg.kernelOverhead, cfg.workItemCost}
+	{
+		for (const auto& kCfg : cfg.kernels)
+			kernelCosts[kCfg.name].push_back({kCfg.globalSize, kCfg.overhead, kCfg.workItemCost});
+	}
+
+	DeviceClock::Duration PerformanceModel::GetTransferDuration(TransferDirection direction, std::size_t size) const
+	{
+		const auto bandwidth = [&]()
+		{
+			switch (direction)
+			{
+			case TransferDirection::HostToDevice: return hostToDeviceBandwidth;
+			case TransferDirection::DeviceToHost: return deviceToHostBandwidth;
+			default:
+			case TransferDirection::DeviceToDevice: return deviceToDeviceBandwidth;
+			}
+		}();
+
+		if (bandwidth <= 0)
+			return ToDuration(copyLatency);
+
+		return ToDuration(copyLatency + size / bandwidth);
+	}
+
+	DeviceClock::Duration PerformanceModel::GetKernelDuration(const std::string& name, std::size_t globalSize) const
+	{
+		const auto& cost = FindKernelCost(name, globalSize);
+		return ToDuration(cost.overhead + cost.workItemCost * globalSize);
+	}
+
+	DeviceClock::Duration PerformanceModel::GetCachedBuildDuration() const
+	{
+		return ToDuration(cachedBuildLatency);
+	}
+
+	const PerformanceModel::KernelCost& PerformanceModel::FindKernelCost(const std::string& name, std::size_t globalSize) const
+	{
+		const auto found = kernelCosts.find(name);
+
+		if (found == kernelCosts.end())
+			return defaultKernelCost;
+
+		const KernelCost* anySize = nullptr;
+
+		for (const auto& cost : found->second)
+		{
+			if (cost.globalSize == globalSize)
+				return cost;
+			if (cost.globalSize == 0 && anySize == nullptr)
+				anySize = &cost;
+		}
+
+		return anySize != nullptr ? *anySize : defaultKernelCost;
+	}
+
+}
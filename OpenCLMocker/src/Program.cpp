@@ -0,0 +1,169 @@
+#include <OpenCLMocker/Program.hpp>
+
+#include <OpenCLMocker/Exception.hpp>
+#include <OpenCLMocker/ProgramCache.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace OpenCL
+{
+
+	Program::Program(std::vector<Device*> devices_, std::vector<InternedText> binaries)
+		: devices(std::move(devices_))
+		, executable{std::move(binaries), nullptr}
+	{
+	}
+
+	std::vector<Device*> Program::StartBuild(const std::vector<Device*>& buildDevices, std::string buildOptions)
+	{
+		auto lock = std::lock_guard{buildMutex};
+
+		if (IsBuilding())
+			throw Exception(CL_INVALID_OPERATION, "clBuildProgram: attempt to build a program which is being built.");
+		if (attachedKernels != 0)
+			throw Exception(CL_INVALID_OPERATION, "clBuildProgram: attempt to build a program with attached kernels.");
+		if (!source && executable.binaries.empty())
+			throw Exception(CL_INVALID_OPERATION, "clBuildProgram: attempt to build a program without sources or binaries.");
+
+		if (devices.empty())
+			devices = buildDevices;
+
+		for (auto i = std::size_t{0}; i < buildDevices.size(); ++i)
+			if (std::find(devices.begin(), devices.end(), buildDevices[i]) == devices.end())
+				throw Exception{CL_INVALID_DEVICE, "clBuildProgram: device_list[" + std::to_string(i) + "] is not associated with the passed program."};
+
+		// Every device of the program is compiled for, so all of them get a status.
+		buildStatuses.assign(devices.size(), BuildStatus::InProgress);
+		buildLogs.assign(devices.size(), "");
+		options = std::move(buildOptions);
+		return devices;
+	}
+
+	bool Program::Compile(Executable& result) const
+	{
+		auto lock = std::unique_lock{buildMutex};
+		const auto buildDevices = devices;
+		const auto buildOptions = options;
+		result.binaries = executable.binaries;
+		lock.unlock();
+
+		if (!source)
+		{
+			// Binaries of the mocker are sources.
+			result.kernelTable = KernelTable::Get(result.binaries.front(), buildOptions);
+			return true;
+		}
+
+		auto& cache = ProgramCache::GetInstance();
+		result.kernelTable = KernelTable::Get(source, buildOptions);
+		auto cached = true;
+
+		result.binaries.resize(buildDevices.size());
+
+		for (auto i = std::size_t{0}; i < buildDevices.size(); ++i)
+		{
+			const auto key = ProgramCache::GetKey(source, buildOptions, *buildDevices[i]);
+
+			if (auto binary = cache.Find(key))
+			{
+				result.binaries[i] = std::move(*binary);
+				continue;
+			}
+
+			// The mocker does not compile anything, the binary is the source it was built from.
+			result.binaries[i] = source;
+			cache.Store(key, result.binaries[i]);
+			cached = false;
+		}
+
+		return cached;
+	}
+
+	void Program::FinishBuild(Executable built)
+	{
+		auto lock = std::lock_guard{buildMutex};
+		executable = std::move(built);
+		buildStatuses.assign(buildStatuses.size(), BuildStatus::Success);
+	}
+
+	void Program::FailBuild(const std::string& log)
+	{
+		auto lock = std::lock_guard{buildMutex};
+		buildStatuses.assign(buildStatuses.size(), BuildStatus::Error);
+		buildLogs.assign(buildLogs.size(), log);
+	}
+
+	std::shared_ptr<const KernelTable> Program::AttachKernel()
+	{
+		auto lock = std::lock_guard{buildMutex};
+
+		if (IsBuilding())
+			throw Exception{CL_INVALID_PROGRAM_EXECUTABLE, "The program is being built."};
+
+		const auto built = std::all_of(buildStatuses.begin(), buildStatuses.end(), [](const auto& status) { return status == BuildStatus::Success; });
+
+		if (executable.binaries.empty() && built)
+			throw Exception{CL_INVALID_BINARY};
+
+		++attachedKernels;
+		return executable.kernelTable;
+	}
+
+	void Program::DetachKernel()
+	{
+		auto lock = std::lock_guard{buildMutex};
+		--attachedKernels;
+	}
+
+	std::vector<Device*> Program::GetDevices() const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return devices;
+	}
+
+	std::vector<InternedText> Program::GetBinaries() const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return executable.binaries;
+	}
+
+	std::shared_ptr<const KernelTable> Program::GetKernelTable() const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return IsBuilding() ? nullptr : executable.kernelTable;
+	}
+
+	BuildStatus Program::GetBuildStatus(std::size_t device) const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return device < buildStatuses.size() ? buildStatuses[device] : BuildStatus::None;
+	}
+
+	std::string Program::GetBuildLog(std::size_t device) const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return device < buildLogs.size() ? buildLogs[device] : std::string{};
+	}
+
+	std::string Program::GetBuildOptions() const
+	{
+		auto lock = std::lock_guard{buildMutex};
+		return options;
+	}
+
+	bool Program::HasKernelArgInfo() const
+	{
+		auto words = std::istringstream{GetBuildOptions()};
+		return source && std::find(std::istream_iterator<std::string>{words}, std::istream_iterator<std::string>{}, "-cl-kernel-arg-info") != std::istream_iterator<std::string>{};
+	}
+
+	// The lock must be held.
+	bool Program::IsBuilding() const
+	{
+		return std::find(buildStatuses.begin(), buildStatuses.end(), BuildStatus::InProgress) != buildStatuses.end();
+	}
+
+}
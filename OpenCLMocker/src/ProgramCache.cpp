@@ -0,0 +1,112 @@
+#include <OpenCLMocker/ProgramCache.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+#include <OpenCLMocker/Device.hpp>
+#include <OpenCLMocker/Hash.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		// Changes whenever the binaries the mocker produces change, so that old entries are never used.
+		constexpr std::uint64_t FormatVersion = 1;
+	}
+
+	ProgramCache::ProgramCache(std::optional<std::filesystem::path> root_)
+		: root(std::move(root_))
+	{
+		auto error = std::error_code{};
+
+		if (root.has_value() && !std::filesystem::create_directories(*root, error) && error)
+		{
+			std::cerr << "CL Mocker: Failed to create the program cache " << *root << ", caching is disabled." << std::endl;
+			root.reset();
+		}
+	}
+
+	ProgramCache& ProgramCache::GetInstance()
+	{
+		static auto instance = ProgramCache{Config::GetInstance().programCacheRoot};
+		return instance;
+	}
+
+	std::uint64_t ProgramCache::GetKey(const InternedText& source, const std::string& options, const Device& device)
+	{
+		const auto identity = device.name + '\n' + device.version + '\n' + device.driver;
+
+		auto key = Hash64(identity.data(), identity.size(), FormatVersion);
+		key = Hash64(options.data(), options.size(), key);
+		// The source is hashed once when it is interned.
+		const auto sourceHash = source.GetHash();
+		return Hash64(&sourceHash, sizeof(sourceHash), key);
+	}
+
+	std::optional<InternedText> ProgramCache::Find(std::uint64_t key) const
+	{
+		if (!IsEnabled())
+			return std::nullopt;
+
+		auto file = std::ifstream{GetPath(key), std::ios::binary};
+
+		if (!file)
+			return std::nullopt;
+
+		auto binary = std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+		if (file.bad())
+			return std::nullopt;
+
+		return InternedText::Get(std::move(binary));
+	}
+
+	void ProgramCache::Store(std::uint64_t key, const InternedText& binary) const
+	{
+		if (!IsEnabled())
+			return;
+
+		const auto path = GetPath(key);
+		auto temporary = path;
+		temporary += "." + std::to_string(std::random_device{}()) + ".tmp";
+
+		{
+			auto file = std::ofstream{temporary, std::ios::binary};
+			file.write(binary.GetData(), static_cast<std::streamsize>(binary.GetSize()));
+
+			if (!file)
+			{
+				std::cerr << "CL Mocker: Failed to write the program cache entry " << temporary << "." << std::endl;
+				file.close();
+
+				auto error = std::error_code{};
+				std::filesystem::remove(temporary, error);
+				return;
+			}
+		}
+
+		auto error = std::error_code{};
+		std::filesystem::rename(temporary, path, error);
+
+		if (error)
+			std::filesystem::remove(temporary, error);
+	}
+
+	std::filesystem::path ProgramCache::GetPath(std::uint64_t key) const
+	{
+		auto name = std::ostringstream{};
+		name << std::hex;
+		name.width(16);
+		name.fill('0');
+		name << key << ".bin";
+		return *root / name.str();
+	}
+
+}
@@ -1,21 +1,341 @@
 #include <OpenCLMocker/Queue.hpp>
 
 #include <OpenCLMocker/Event.hpp>
+#include <OpenCLMocker/Exception.hpp>
 #include <OpenCLMocker/Kernel.hpp>
+#include <OpenCLMocker/NativeKernels.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
 
 namespace OpenCL
 {
 
-	void Queue::EnqueueNDRangeKernel(const Kernel& kernel, const std::vector<size_t>& global_work_offset, const std::vector<size_t>& global_work_size, const std::vector<size_t>& local_work_size, const std::vector<cl_event>& event_wait_list, cl_event* ev)
+	Queue::Queue(Context* context, Device* device)
+		: ctx(context)
+		, device(device)
+		, lastEnd(device->clock.Now())
+	{
+	}
+
+	Queue::~Queue()
+	{
+		{
+			auto lock = std::lock_guard{mutex};
+			stopping = true;
+		}
+
+		hasWork.notify_all();
+
+		if (worker.joinable())
+		{
+			// The worker dropped the last reference, it returns right after.
+			if (worker.get_id() == std::this_thread::get_id())
+				worker.detach();
+			else
+				worker.join();
+		}
+
+		// Commands which were never flushed never run.
+		while (const auto command = submitted.Pop())
+			delete command;
+	}
+
+	Retained<Event> Queue::Enqueue(cl_command_type type, const DeviceClock::Duration& duration, const std::vector<cl_event>& event_wait_list, std::function<void()> work, cl_event* ev)
 	{
-		auto mockEvent = std::make_unique<Event>(
-			event_wait_list,
-			std::chrono::nanoseconds(3000 + rand() % 3000));
+		auto command = std::make_unique<Command>();
+		command->work = std::move(work);
+
+		for (const auto rawEvent : event_wait_list)
+		{
+			const auto waitEvent = MapType(rawEvent);
 
-		RegisterEvent(mockEvent.get());
+			if (!Event::Validate(waitEvent))
+				throw Exception{CL_INVALID_EVENT_WAIT_LIST};
+			if (waitEvent->ctx != ctx)
+				throw Exception{CL_INVALID_CONTEXT, "Events in the wait list should have the same context as the queue."};
+
+			command->waitList.emplace_back(*waitEvent);
+		}
+
+		const auto handle = MakeHandle(std::make_unique<Event>(*this, type, duration));
+		auto& mockEvent = *MapType(handle);
+
+		// The command takes over the initial reference unless the caller asked for the event.
+		command->event = ev != nullptr ? Retained{mockEvent} : Retained<Event>::Adopt(mockEvent);
+		auto ret = command->event;
 
 		if (ev != nullptr)
-			*ev = MakeHandle(std::move(mockEvent));
+			*ev = handle;
+
+		command->hasWaitList = !event_wait_list.empty();
+
+		// Counted once linked in, so that flushes only release commands the worker can take.
+		submitted.Push(command.release());
+		enqueuedCount.fetch_add(1, std::memory_order_release);
+
+		return ret;
+	}
+
+	std::size_t Queue::Flush()
+	{
+		if (const auto count = flushed.load(std::memory_order_acquire); count == enqueuedCount.load(std::memory_order_acquire))
+			return count;
+
+		auto count = std::size_t{0};
+
+		{
+			auto lock = std::lock_guard{mutex};
+			count = enqueuedCount.load(std::memory_order_acquire);
+
+			if (count == flushed)
+				return count;
+
+			flushes.push_back({count, device->clock.Now()});
+			flushed = count;
+
+			if (!keepsAlive)
+			{
+				keepsAlive = true;
+				Retain();
+			}
+
+			if (!worker.joinable())
+				worker = std::thread{[this]() { Process(); }};
+		}
+
+		hasWork.notify_one();
+		return count;
+	}
+
+	void Queue::Wait()
+	{
+		// Exactly the commands this flush submitted, later ones may be enqueued meanwhile.
+		const auto target = Flush();
+
+		auto lock = std::unique_lock{mutex};
+		++drainWaiters;
+		drained.wait(lock, [&]() { return completedPrefix >= target; });
+		--drainWaiters;
+		const auto end = lastEnd;
+		lock.unlock();
+
+		device->clock.WaitUntil(end);
+	}
+
+	void Queue::AddImplicitDependencies(Command& command)
+	{
+		if (!outOfOrderExecutionMode)
+		{
+			if (lastEvent)
+				command.waitList.emplace_back(lastEvent);
+			lastEvent = command.event;
+			return;
+		}
+
+		const auto type = command.event->GetType();
+		const auto isBarrier = type == CL_COMMAND_BARRIER;
+
+		// Markers and barriers without a wait list wait for every command enqueued before them.
+		if ((isBarrier || type == CL_COMMAND_MARKER) && !command.hasWaitList)
+			for (const auto& previous : sinceBarrier)
+				if (!previous->IsFinished())
+					command.waitList.emplace_back(previous);
+
+		if (lastBarrier && !lastBarrier->IsFinished())
+			command.waitList.emplace_back(lastBarrier);
+
+		if (isBarrier)
+		{
+			lastBarrier = command.event;
+			sinceBarrier.clear();
+			sinceBarrierPruneSize = 64;
+			return;
+		}
+
+		sinceBarrier.emplace_back(command.event);
+
+		if (sinceBarrier.size() >= sinceBarrierPruneSize)
+		{
+			std::erase_if(sinceBarrier, [](const auto& previous) { return previous->IsFinished(); });
+			sinceBarrierPruneSize = std::max<std::size_t>(64, sinceBarrier.size() * 2);
+		}
+	}
+
+	void Queue::Process()
+	{
+		auto& clock = device->clock;
+		auto lock = std::unique_lock{mutex};
+
+		while (true)
+		{
+			for (; received < flushed; ++received)
+			{
+				auto command = std::unique_ptr<Command>{TakeSubmitted()};
+				command->sequence = received;
+
+				while (flushes.front().count <= received)
+					flushes.pop_front();
+
+				command->event->Submit(flushes.front().time);
+				AddImplicitDependencies(*command);
+				Receive(std::move(command));
+			}
+
+			while (!ready.empty())
+			{
+				auto command = std::move(ready.front());
+				ready.pop_front();
+
+				lock.unlock();
+				const auto end = Start(*command);
+				lock.lock();
+
+				running.emplace(end, std::move(command));
+			}
+
+			if (!running.empty() && (clock.IsVirtual() || running.begin()->first <= clock.Now()))
+			{
+				auto node = running.extract(running.begin());
+				const auto sequence = node.mapped()->sequence;
+
+				// Completion may unblock commands of this queue, which needs the lock.
+				lock.unlock();
+				node.mapped()->event->Complete(node.mapped()->result);
+				node.mapped().reset();
+				lock.lock();
+
+				lastEnd = std::max(lastEnd, node.key());
+				++completedCount;
+
+				if (sequence != completedPrefix)
+					completedAfterPrefix.insert(sequence);
+				else
+				{
+					++completedPrefix;
+
+					while (!completedAfterPrefix.empty() && *completedAfterPrefix.begin() == completedPrefix)
+					{
+						completedAfterPrefix.erase(completedAfterPrefix.begin());
+						++completedPrefix;
+					}
+				}
+
+				if (drainWaiters != 0)
+					drained.notify_all();
+				continue;
+			}
+
+			if (keepsAlive && completedCount == flushed)
+			{
+				keepsAlive = false;
+				lock.unlock();
+
+				// Destroys the queue when the application released it, nothing may be touched afterwards.
+				if (Release())
+					return;
+
+				lock.lock();
+				continue;
+			}
+
+			// Only set once no flushed command is pending.
+			if (stopping)
+				return;
+
+			if (!running.empty())
+				hasWork.wait_until(lock, running.begin()->first);
+			else
+				hasWork.wait(lock, [this]() { return received < flushed || !ready.empty() || stopping; });
+		}
+	}
+
+	Queue::Command* Queue::TakeSubmitted()
+	{
+		// Flushed commands are always pushed, at worst the producer of the oldest one is still linking it in.
+		for (auto command = submitted.Pop(); ; command = submitted.Pop())
+		{
+			if (command != nullptr)
+				return command;
+
+			std::this_thread::yield();
+		}
+	}
+
+	void Queue::Receive(std::unique_ptr<Command> command)
+	{
+		// Until all the dependencies are complete the command is owned by their completion hooks.
+		const auto raw = command.release();
+
+		for (const auto& waitEvent : raw->waitList)
+		{
+			// Notifies under the lock, once it is released the queue may be drained and destroyed.
+			const auto registered = waitEvent->AddCompletionHook([this, raw]()
+				{
+					auto lock = std::lock_guard{mutex};
+					Unblock(raw);
+					hasWork.notify_one();
+				});
+
+			if (registered)
+				++raw->blockers;
+		}
+
+		Unblock(raw);
+	}
+
+	void Queue::Unblock(Command* command)
+	{
+		if (--command->blockers == 0)
+			ready.emplace_back(command);
+	}
+
+	Event::TimePoint Queue::Start(Command& command)
+	{
+		auto& clock = device->clock;
+		auto& ev = *command.event;
+
+		// Virtual time is fully determined by the host timeline, so the moment the worker got to the command does not matter.
+		auto earliest = clock.IsVirtual() ? ev.GetSubmitted() : clock.Now();
+
+		for (const auto& waitEvent : command.waitList)
+		{
+			earliest = std::max(earliest, waitEvent->GetEnd());
+
+			if (waitEvent->GetStatus() < 0)
+				command.result = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+		}
+
+		command.waitList.clear();
+		ev.Run(device->engines.Reserve(EngineSchedule::GetEngineType(ev.GetType()), earliest, ev.GetDuration()));
+
+		if (command.result == CL_COMPLETE && command.work)
+		{
+			try
+			{
+				command.work();
+			}
+			catch (const Exception& ex)
+			{
+				command.result = ex.GetStatus();
+			}
+			catch (...)
+			{
+				command.result = CL_OUT_OF_RESOURCES;
+			}
+		}
+
+		return ev.GetEnd();
+	}
+
+	void Queue::EnqueueNDRangeKernel(const Kernel& kernel, const std::vector<size_t>& global_work_offset, const std::vector<size_t>& global_work_size, const std::vector<size_t>& local_work_size, const std::vector<cl_event>& event_wait_list, cl_event* ev)
+	{
+		const auto globalSize = std::accumulate(global_work_size.begin(), global_work_size.end(), std::size_t{1}, std::multiplies<>{});
+
+		auto work = NativeKernels::GetInstance().Prepare(kernel, global_work_offset, global_work_size, local_work_size);
+
+		Enqueue(CL_COMMAND_NDRANGE_KERNEL, device->performance.GetKernelDuration(kernel.name, globalSize), event_wait_list, std::move(work), ev);
 	}
 
-}
\ No newline at end of file
+}
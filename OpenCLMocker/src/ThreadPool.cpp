@@ -0,0 +1,194 @@
+#include <OpenCLMocker/ThreadPool.hpp>
+
+#include <OpenCLMocker/Config.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+
+namespace OpenCL
+{
+
+	namespace
+	{
+		constexpr auto NotAWorker = std::numeric_limits<std::size_t>::max();
+
+		thread_local const ThreadPool* currentPool = nullptr;
+		thread_local std::size_t currentIndex = NotAWorker;
+	}
+
+	ThreadPool::ThreadPool(std::size_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (auto i = std::size_t{0}; i < threadCount; ++i)
+			queues.emplace_back(std::make_unique<WorkQueue>());
+
+		for (auto i = std::size_t{0}; i < threadCount; ++i)
+			threads.emplace_back([this, i]() { Process(i); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			auto lock = std::lock_guard{sleepMutex};
+			stopping = true;
+		}
+
+		hasWork.notify_all();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	ThreadPool& ThreadPool::GetInstance()
+	{
+		static auto instance = ThreadPool{Config::GetInstance().workerThreads};
+		return instance;
+	}
+
+	void ThreadPool::Submit(Task task)
+	{
+		const auto index = currentPool == this
+			? currentIndex
+			: nextQueue++ % queues.size();
+
+		{
+			auto& queue = *queues[index];
+			auto lock = std::lock_guard{queue.mutex};
+			queue.tasks.emplace_back(std::move(task));
+		}
+
+		{
+			auto lock = std::lock_guard{sleepMutex};
+			++pending;
+		}
+
+		hasWork.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body)
+	{
+		grain = std::max<std::size_t>(grain, 1);
+		const auto chunks = (count + grain - 1) / grain;
+
+		if (chunks <= 1)
+		{
+			if (count != 0)
+				body(0, count);
+			return;
+		}
+
+		struct State
+		{
+			std::atomic<std::size_t> remaining;
+			std::mutex mutex;
+			std::exception_ptr error;
+		};
+
+		// Shared with the chunks: the last one notifies after its decrement, when the caller may have returned already.
+		const auto state = std::make_shared<State>();
+		state->remaining = chunks;
+
+		// Only called before the decrement, it refers to the caller's stack.
+		const auto run = [&](std::size_t chunk)
+		{
+			try
+			{
+				const auto begin = chunk * grain;
+				body(begin, std::min(begin + grain, count));
+			}
+			catch (...)
+			{
+				auto lock = std::lock_guard{state->mutex};
+				if (state->error == nullptr)
+					state->error = std::current_exception();
+			}
+		};
+
+		const auto finish = [](State& chunkState)
+		{
+			if (--chunkState.remaining == 0)
+				chunkState.remaining.notify_all();
+		};
+
+		for (auto chunk = std::size_t{1}; chunk < chunks; ++chunk)
+			Submit([&run, finish, state, chunk]()
+				{
+					run(chunk);
+					finish(*state);
+				});
+
+		run(0);
+		finish(*state);
+
+		const auto self = currentPool == this ? currentIndex : NotAWorker;
+
+		for (auto left = state->remaining.load(); left != 0; left = state->remaining.load())
+		{
+			if (!RunOne(self))
+				state->remaining.wait(left);
+		}
+
+		if (state->error != nullptr)
+			std::rethrow_exception(state->error);
+	}
+
+	void ThreadPool::Process(std::size_t index)
+	{
+		currentPool = this;
+		currentIndex = index;
+
+		while (true)
+		{
+			if (RunOne(index))
+				continue;
+
+			auto lock = std::unique_lock{sleepMutex};
+			hasWork.wait(lock, [&]() { return stopping || pending > 0; });
+
+			if (stopping && pending <= 0)
+				return;
+		}
+	}
+
+	bool ThreadPool::RunOne(std::size_t index)
+	{
+		auto task = Task{};
+
+		if (index != NotAWorker)
+		{
+			auto& own = *queues[index];
+			auto lock = std::lock_guard{own.mutex};
+
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+			}
+		}
+
+		const auto start = index == NotAWorker ? std::size_t{0} : index + 1;
+
+		for (auto i = std::size_t{0}; !task && i < queues.size(); ++i)
+		{
+			auto& victim = *queues[(start + i) % queues.size()];
+			auto lock = std::lock_guard{victim.mutex};
+
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+			}
+		}
+
+		if (!task)
+			return false;
+
+		--pending;
+		task();
+		return true;
+	}
+
+}
@@ -2,24 +2,35 @@
 
 #include <OpenCLMocker/Object.hpp>
 
+#include <OpenCLMocker/DeviceMemory.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
+#include <OpenCLMocker/MemoryPool.hpp>
 #include <OpenCLMocker/MemFlags.hpp>
+#include <OpenCLMocker/Pooled.hpp>
 #include <OpenCLMocker/Retainable.hpp>
+#include <OpenCLMocker/Retained.hpp>
 
 #include <CL/cl.h>
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace OpenCL
 {
 	struct Context;
 
-	class Buffer : public Object, public Retainable, private BufferValidation
+	class Buffer : public Object, public Retainable, public Pooled<Buffer>
 	{
 	public:
-		std::unique_ptr<char[]> gpuMemory = nullptr;
+		DeviceMemory gpuMemory;
+		// Pool of the context, kept alive until the storage is recycled.
+		std::shared_ptr<MemoryPool> memoryPool;
 		std::unique_ptr<char[]> hostMemory = nullptr;
+		// Sub-buffers alias the storage of their parent and keep it alive.
+		Retained<Buffer> parent;
 
 		OpenCL::Context* ctx = nullptr;
 		char* start = nullptr;
@@ -28,18 +39,59 @@ namespace OpenCL
 
 		Buffer(MemFlags flags_);
 		Buffer(Context* context, MemFlags flags_, size_t size, void* host_ptr);
-		Buffer(Buffer&& other) : Object(std::move(other)) {}
+		Buffer(Buffer&& other);
+		~Buffer();
 
 		const MemFlags& GetMemFlags() const { return flags; }
 
-		static bool Validate(const Buffer* buffer) { return buffer != nullptr && buffer->Object::Validate() && buffer->BufferValidation::Validate(); }
+		static bool Validate(const Buffer* buffer) { return buffer != nullptr; }
+
+		// Copies between the buffer and host memory. Nothing is copied when the host memory is the buffer
+		// storage itself, as with CL_MEM_USE_HOST_PTR buffers read into or written from their host pointer.
+		void Read(std::size_t offset, std::size_t length, void* ptr) const;
+		void Write(std::size_t offset, std::size_t length, const void* ptr);
+
+		struct Mapping
+		{
+			char* ptr;
+			std::size_t offset;
+			std::size_t length;
+			cl_map_flags flags;
+		};
+
+		// Mapped regions point straight into the buffer storage, mapping and unmapping never copy.
+		void* Map(std::size_t offset, std::size_t length, cl_map_flags mapFlags);
+		// Throws CL_INVALID_VALUE unless the pointer was returned by Map and is still mapped.
+		Mapping Unmap(const void* ptr);
+		cl_uint GetMapCount() const;
 
 		void Dump(const std::string& operation);
+		// Dumps the range changed by the operation, unless it has the same contents as when it was dumped last time.
+		void Dump(const std::string& operation, std::size_t offset, std::size_t length);
+
+		// Returns the buffer if the kernel argument value is a live buffer handle.
+		static Retained<Buffer> FindByValue(const void* value, std::size_t size);
 
 	private:
 		MemFlags flags;
 		std::atomic<std::size_t> dumpIndex = 0;
+
+		struct DumpedRange
+		{
+			std::size_t offset;
+			std::size_t length;
+			std::uint64_t hash;
+		};
+
+		mutable std::mutex mapMutex;
+		std::vector<Mapping> mappings;
+
+		std::mutex dumpMutex;
+		// Latest dumped ranges, they never overlap.
+		std::vector<DumpedRange> dumpedRanges;
+
+		bool UpdateDumpedRanges(std::size_t offset, std::size_t length, std::uint64_t hash);
 	};
 }
 
-MapToCl(OpenCL::Buffer, cl_mem)
+MapToCl(OpenCL::Buffer, cl_mem, Buffer)
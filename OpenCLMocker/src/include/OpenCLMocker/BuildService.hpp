@@ -0,0 +1,70 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+#include <OpenCLMocker/ThreadPool.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace OpenCL
+{
+	class Device;
+
+	// Limits program builds to Device::parallelBuilds at a time per device. Asynchronous builds wait in
+	// a queue for free slots and run on a bounded set of build threads, started with the first of them.
+	class BuildService
+	{
+		ForbidCopy(BuildService);
+		ForbidMove(BuildService);
+
+	public:
+		using Build = std::function<void()>;
+
+		static BuildService& GetInstance();
+
+		// Queued builds start in submission order, a build never overtakes an earlier one sharing a device.
+		// Done is called on the callback thread once the build released its slots, so that it can start another
+		// build of the same devices.
+		void Submit(std::vector<Device*> devices, Build build, Build done);
+		// Runs the build on the calling thread once it is its turn, in the same order as the submitted builds.
+		void Run(const std::vector<Device*>& devices, const Build& build);
+
+	private:
+		struct Job
+		{
+			std::vector<Device*> devices;
+			Build build;
+			Build done;
+			// Set for builds run by a waiting Run, which runs them itself once they start.
+			bool* started = nullptr;
+		};
+
+		std::mutex mutex;
+		// Wakes up Run, when its build started or the service stops.
+		std::condition_variable runStarted;
+		std::deque<Job> queued;
+		// Builds running per device.
+		std::unordered_map<const Device*, std::size_t> running;
+		std::size_t threadCount;
+		std::size_t activeJobs = 0;
+		bool stopping = false;
+		// Declared last, so that it joins the builds still running before the rest of the service is destroyed.
+		std::optional<ThreadPool> threads;
+
+		explicit BuildService(std::size_t threadCount);
+		// Drops the builds which did not start yet.
+		~BuildService();
+
+		bool HasFreeSlots(const std::vector<Device*>& devices) const;
+		void Acquire(const std::vector<Device*>& devices);
+		void Release(const std::vector<Device*>& devices);
+		// Hands the queued builds which can start to the build threads, needs the lock.
+		void StartQueued();
+	};
+}
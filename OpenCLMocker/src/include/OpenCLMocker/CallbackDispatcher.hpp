@@ -0,0 +1,40 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace OpenCL
+{
+	// Runs application callbacks on a single thread in the order they were posted, so that
+	// they never run on a queue worker and never reorder completions.
+	class CallbackDispatcher
+	{
+		ForbidCopy(CallbackDispatcher);
+		ForbidMove(CallbackDispatcher);
+
+	public:
+		using Callback = std::function<void()>;
+
+		CallbackDispatcher() = default;
+		// Runs the callbacks still pending before returning.
+		~CallbackDispatcher();
+
+		static CallbackDispatcher& GetInstance();
+
+		void Post(Callback callback);
+
+	private:
+		std::mutex mutex;
+		std::condition_variable hasWork;
+		std::deque<Callback> callbacks;
+		std::thread thread;
+		bool stopping = false;
+
+		void Process();
+	};
+}
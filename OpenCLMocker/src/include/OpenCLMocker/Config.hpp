@@ -11,6 +11,46 @@
 
 namespace OpenCL
 {
+    class KernelCostConfig
+    {
+        ForbidCopy(KernelCostConfig);
+        DefaultMove(KernelCostConfig);
+
+    public:
+        std::string name;
+        // Total number of work items the override applies to. 0 means any.
+        std::size_t globalSize = 0;
+        // Nanoseconds.
+        double overhead = 3000;
+        double workItemCost = 0;
+
+        KernelCostConfig() = default;
+    };
+
+    class PerformanceConfig
+    {
+        ForbidCopy(PerformanceConfig);
+        DefaultMove(PerformanceConfig);
+
+    public:
+        // GB/s, which is the same as bytes per nanosecond.
+        double hostToDeviceBandwidth = 16;
+        double deviceToHostBandwidth = 16;
+        double deviceToDeviceBandwidth = 256;
+        // Nanoseconds.
+        double copyLatency = 1000;
+        // Nanoseconds a build takes when the binary is found in the program cache.
+        double cachedBuildLatency = 100000;
+        double kernelOverhead = 3000;
+        double workItemCost = 0;
+        std::vector<KernelCostConfig> kernels;
+        // Number of commands of each kind the device can run simultaneously.
+        std::size_t computeEngines = 4;
+        std::size_t copyEngines = 2;
+
+        PerformanceConfig() = default;
+    };
+
     class DeviceConfig
     {
         ForbidCopy(DeviceConfig);
@@ -20,6 +60,9 @@ namespace OpenCL
         std::string name = "Fake Device";
         std::string version = "0.0.1";
         std::string driver = "0.0.1";
+        // Number of programs the device can build simultaneously.
+        std::size_t parallelBuilds = 2;
+        PerformanceConfig performance;
 
         DeviceConfig() = default;
     };
@@ -53,6 +96,24 @@ namespace OpenCL
         std::optional<std::filesystem::path> dumpBuffersRoot;
         // Contains list of operations allowed to be dumped. None means any.
         std::vector<std::string> dumpBuffersOpFilter;
+        // Bytes of dumped contents waiting for the writer thread before dumping operations block.
+        std::size_t dumpStagingSize = 64 * 1024 * 1024;
+        // "files" for a file per dump or "archive" for a single archive per process.
+        std::string dumpFormat = "files";
+        // Simulated device time: waits jump device clocks forward instead of sleeping.
+        bool virtualTime = false;
+        // Shared objects providing CPU implementations of kernels, see OpenCLMocker/NativeKernel.hpp.
+        std::vector<std::filesystem::path> kernelPlugins;
+        // Threads executing native kernels. 0 means one per hardware thread.
+        std::size_t workerThreads = 0;
+        // Threads running asynchronous program builds. 0 means one per hardware thread.
+        std::size_t buildThreads = 0;
+        // Bytes of released buffer storage cached per context for reuse. 0 disables caching.
+        std::size_t bufferPoolLimit = 256 * 1024 * 1024;
+        // Bytes from which buffer transfers are split over the worker threads. 0 keeps them on a single thread.
+        std::size_t parallelCopyThreshold = 16 * 1024 * 1024;
+        // Directory of the persistent program binary cache. Builds are never cached when not set.
+        std::optional<std::filesystem::path> programCacheRoot;
 
         Config() = default;
 
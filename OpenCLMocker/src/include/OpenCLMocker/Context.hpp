@@ -4,6 +4,7 @@
 
 #include <OpenCLMocker/Device.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
+#include <OpenCLMocker/MemoryPool.hpp>
 #include <OpenCLMocker/Platform.hpp>
 #include <OpenCLMocker/Retainable.hpp>
 #include <OpenCLMocker/TypeValidation.hpp>
@@ -11,24 +12,26 @@
 #include <CL/cl.h>
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace OpenCL
 {
-	class Context : public Object, public Retainable, private ContextValidation
+	class Context : public Object, public Retainable
 	{
 	public:
 		bool interopUserSync = false;
 		Platform* platform = nullptr;
 		std::vector<Device*> devices;
+		std::shared_ptr<MemoryPool> memoryPool = std::make_shared<MemoryPool>();
 
 		std::function<void(const std::string& errorInfo, const std::vector<uint8_t>& privateInfo)> errorCallback;
 
 		Context() = default;
 
-		static bool Validate(const Context* ctx) { return ctx != nullptr && ctx->Object::Validate() && ctx->ContextValidation::Validate(); }
+		static bool Validate(const Context* ctx) { return ctx != nullptr; }
 	};
 }
 
-MapToCl(OpenCL::Context, cl_context)
+MapToCl(OpenCL::Context, cl_context, Context)
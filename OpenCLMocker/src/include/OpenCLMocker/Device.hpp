@@ -2,7 +2,10 @@
 
 #include <OpenCLMocker/Object.hpp>
 
+#include <OpenCLMocker/DeviceClock.hpp>
+#include <OpenCLMocker/EngineSchedule.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
+#include <OpenCLMocker/PerformanceModel.hpp>
 #include <OpenCLMocker/TypeValidation.hpp>
 
 #include <CL/cl.h>
@@ -20,8 +23,12 @@ namespace OpenCL
         std::string name = "";
         std::string version = "";
         std::string driver = "";
+        std::size_t parallelBuilds = 2;
+        DeviceClock clock;
+        PerformanceModel performance;
+        EngineSchedule engines;
 
-        Device(Platform* platform) : _platform(platform) {}
+        Device(Platform* platform);
         Device(Platform* platform, const class DeviceConfig& cfg);
 
         Platform* GetPlatform() const { return _platform; }
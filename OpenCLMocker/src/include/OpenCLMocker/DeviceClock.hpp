@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace OpenCL
+{
+	// Time source of a device. In virtual mode the clock never sleeps: it only
+	// jumps forward when someone waits for a point in the simulated future.
+	class DeviceClock
+	{
+	public:
+		using Clock = std::chrono::high_resolution_clock;
+		using TimePoint = Clock::time_point;
+		using Duration = Clock::duration;
+
+		DeviceClock(bool virtualTime = false);
+		DeviceClock(DeviceClock&& other);
+		DeviceClock& operator=(DeviceClock&& other);
+
+		bool IsVirtual() const { return virtualTime; }
+
+		TimePoint Now() const;
+		void WaitUntil(const TimePoint& point);
+		void SleepFor(const Duration& duration);
+
+	private:
+		bool virtualTime;
+		std::atomic<Duration::rep> virtualNow;
+	};
+}
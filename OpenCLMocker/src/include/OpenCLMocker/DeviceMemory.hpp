@@ -0,0 +1,36 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <cstddef>
+
+namespace OpenCL
+{
+	// Zero-filled storage of a buffer. Large allocations are reserved in the address space and
+	// committed page by page on first touch, so unused parts of huge buffers cost nothing.
+	class DeviceMemory
+	{
+		ForbidCopy(DeviceMemory);
+
+	public:
+		DeviceMemory() = default;
+		explicit DeviceMemory(std::size_t size);
+		DeviceMemory(DeviceMemory&& other) noexcept;
+		DeviceMemory& operator=(DeviceMemory&& other) noexcept;
+		~DeviceMemory();
+
+		char* Get() const { return data; }
+		std::size_t GetSize() const { return size; }
+		bool IsMapped() const { return mapped; }
+
+		// Gives the pages of large storage back to the system while keeping the address range, the contents are lost.
+		void Discard();
+
+	private:
+		char* data = nullptr;
+		std::size_t size = 0;
+		bool mapped = false;
+
+		void Free();
+	};
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <OpenCLMocker/DumpArchive.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenCL
+{
+	struct DumpInfo
+	{
+		std::string operation;
+		std::uint64_t bufferId = 0;
+		std::uint64_t sequence = 0;
+		std::uint64_t globalSequence = 0;
+		std::uint64_t bufferOffset = 0;
+		std::uint64_t bufferSize = 0;
+		// Hash64 of the dumped bytes, computed by the buffer to skip unchanged dumps.
+		std::uint64_t hash = 0;
+	};
+
+	enum class DumpFormat
+	{
+		// A file per dump.
+		Files,
+		// A single append-only archive per process, see OpenCLMocker/DumpArchive.hpp.
+		Archive,
+	};
+
+	// Writes buffer dumps on a background thread. Contents are copied into a bounded staging
+	// ring, producers wait for space when the writer falls behind. Everything is flushed at exit.
+	class DumpWriter
+	{
+		ForbidCopy(DumpWriter);
+		ForbidMove(DumpWriter);
+
+	public:
+		static DumpWriter& GetInstance();
+
+		void Submit(DumpInfo info, const char* data, std::size_t size);
+		// Waits until everything submitted so far is written.
+		void Flush();
+
+	private:
+		struct Entry
+		{
+			DumpInfo info;
+			char* data = nullptr;
+			std::size_t size = 0;
+			// Bytes of the ring taken by the entry, including the padding skipped at the ring end.
+			std::size_t reserved = 0;
+			// Entries which do not fit into the ring own their storage.
+			std::unique_ptr<char[]> oversized;
+			std::atomic<bool> ready = false;
+		};
+
+		std::unique_ptr<char[]> ring;
+		std::size_t capacity;
+		// Monotonic byte counters, the ring holds [released, reserved).
+		std::size_t reserved = 0;
+		std::size_t released = 0;
+
+		std::mutex mutex;
+		std::condition_variable hasWork;
+		std::condition_variable hasSpace;
+		std::deque<std::unique_ptr<Entry>> entries;
+		std::size_t submittedCount = 0;
+		std::size_t writtenCount = 0;
+		bool stopping = false;
+		std::thread writer;
+
+		std::filesystem::path root;
+		DumpFormat format;
+		bool createdRoot = false;
+
+		std::FILE* archive = nullptr;
+		std::uint64_t archiveSize = 0;
+		std::vector<Dump::ArchiveEntry> archiveIndex;
+
+		DumpWriter(std::filesystem::path root, DumpFormat format, std::size_t capacity);
+
+		void Process();
+		void Write(const std::vector<std::unique_ptr<Entry>>& entries);
+		void WriteFile(const Entry& entry);
+		void WriteArchive(const std::vector<std::unique_ptr<Entry>>& entries);
+		void CloseArchive();
+		void Stop();
+	};
+}
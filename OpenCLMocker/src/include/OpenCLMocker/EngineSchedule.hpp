@@ -0,0 +1,38 @@
+#pragma once
+
+#include <OpenCLMocker/DeviceClock.hpp>
+
+#include <CL/cl.h>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace OpenCL
+{
+	enum class EngineType
+	{
+		None,
+		Compute,
+		Copy,
+	};
+
+	// Simulated device engines, commands of every queue of the device are placed on them.
+	class EngineSchedule
+	{
+	public:
+		EngineSchedule(std::size_t computeEngines = 1, std::size_t copyEngines = 1);
+		EngineSchedule(EngineSchedule&& other);
+		EngineSchedule& operator=(EngineSchedule&& other);
+
+		static EngineType GetEngineType(cl_command_type type);
+
+		// Occupies the engine which is free the earliest and returns the command start.
+		DeviceClock::TimePoint Reserve(EngineType type, const DeviceClock::TimePoint& earliest, const DeviceClock::Duration& duration);
+
+	private:
+		std::mutex mutex;
+		std::vector<DeviceClock::TimePoint> compute;
+		std::vector<DeviceClock::TimePoint> copy;
+	};
+}
@@ -2,49 +2,26 @@
 
 #include <OpenCLMocker/ForbidCopy.hpp>
 
-#include <cstdlib>
 #include <filesystem>
+#include <iostream>
 #include <map>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace OpenCL
 {
+	// Snapshot of the process environment taken on first use. It is never modified afterwards,
+	// so lookups from any thread need no lock.
 	class EnvVariable
 	{
-		ForbidCopy(EnvVariable);
-		DefaultMove(EnvVariable);
-
 	public:
-		static const std::optional<std::string>& Get(const std::string& name)
-		{
-			const auto found = values.find(name);
-
-			if (found != values.end())
-				return found->second.value;
-
-			auto var = EnvVariable{name};
-			return values.emplace(name, std::move(var)).first->second.value;
-		}
+		static const std::optional<std::string>& Get(const std::string& name);
 
 	private:
-		inline EnvVariable(const std::string& name)
-		{
-			const auto envValue = std::getenv(name.c_str());
-
-			if (envValue == nullptr)
-			{
-				value = std::nullopt;
-				return;
-			}
-
-			value = envValue;
-		}
-
-		static std::map<std::string, EnvVariable> values;
-		std::optional<std::string> value;
+		static const std::map<std::string, std::optional<std::string>, std::less<>>& GetSnapshot();
 	};
 
 	template <class TType>
@@ -70,34 +47,30 @@ namespace OpenCL
 				return;
 			}
 
-			if constexpr (std::is_same_v<std::string, TValue>)
+			auto tmp = TValue{};
+			auto parsed = true;
+
+			if constexpr (IsVector<TValue>)
 			{
-				value = *envValue;
+				auto ss = std::istringstream{*envValue};
+				auto part = std::string{};
+
+				while (parsed && std::getline(ss, part, ','))
+					parsed = Parse(part, tmp.emplace_back());
 			}
 			else
 			{
-				auto tmp = TValue{};
-				auto ss = std::istringstream{*envValue};
-
-				if constexpr (IsVector<TValue>)
-				{
-					using TElement = typename TValue::value_type;
-					auto part = std::string{};
-
-					while (std::getline(ss, part, ','))
-					{
-						auto element = TElement{};
-						std::istringstream{std::move(part)} >> element;
-						tmp.emplace_back(std::move(element));
-					}
-				}
-				else
-				{
-					ss >> tmp;
-				}
+				parsed = Parse(*envValue, tmp);
+			}
 
-				value = std::move(tmp);
+			if (!parsed)
+			{
+				std::cerr << "Ignoring " << name << ": invalid value \"" << *envValue << "\"." << std::endl;
+				value = std::move(default_);
+				return;
 			}
+
+			value = std::move(tmp);
 		}
 
 		inline bool HasValue() const
@@ -112,6 +85,33 @@ namespace OpenCL
 
 	private:
 		std::optional<TValue> value;
+
+		template <class TElement>
+		static bool Parse(const std::string& text, TElement& element)
+		{
+			// Strings and paths are taken whole, they can contain spaces.
+			if constexpr (std::is_same_v<std::string, TElement> || std::is_same_v<std::filesystem::path, TElement>)
+			{
+				element = text;
+				return true;
+			}
+			else if constexpr (std::is_same_v<bool, TElement>)
+			{
+				if (text == "1" || text == "true" || text == "on")
+					element = true;
+				else if (text == "0" || text == "false" || text == "off")
+					element = false;
+				else
+					return false;
+
+				return true;
+			}
+			else
+			{
+				auto ss = std::istringstream{text};
+				return !(ss >> element).fail() && (ss >> std::ws).eof();
+			}
+		}
 	};
 
 #define DECLARE_ENV_VARIABLE(NAME, TYPE) \
@@ -126,4 +126,13 @@ namespace OpenCL
 
 	DECLARE_ENV_VARIABLE(CLMOCKER_DUMP_BUFFERS_ROOT, std::filesystem::path);
 	DECLARE_ENV_VARIABLE(CLMOCKER_DUMP_BUFFERS_OP_FILTER, std::vector<std::string>);
+	DECLARE_ENV_VARIABLE(CLMOCKER_DUMP_STAGING_SIZE, std::size_t);
+	DECLARE_ENV_VARIABLE(CLMOCKER_DUMP_FORMAT, std::string);
+	DECLARE_ENV_VARIABLE(CLMOCKER_VIRTUAL_TIME, bool);
+	DECLARE_ENV_VARIABLE(CLMOCKER_KERNEL_PLUGINS, std::vector<std::filesystem::path>);
+	DECLARE_ENV_VARIABLE(CLMOCKER_WORKER_THREADS, std::size_t);
+	DECLARE_ENV_VARIABLE(CLMOCKER_BUILD_THREADS, std::size_t);
+	DECLARE_ENV_VARIABLE(CLMOCKER_BUFFER_POOL_LIMIT, std::size_t);
+	DECLARE_ENV_VARIABLE(CLMOCKER_PARALLEL_COPY_THRESHOLD, std::size_t);
+	DECLARE_ENV_VARIABLE(CLMOCKER_PROGRAM_CACHE_ROOT, std::filesystem::path);
 }
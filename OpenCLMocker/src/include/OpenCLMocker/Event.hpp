@@ -2,85 +2,96 @@
 
 #include <OpenCLMocker/Object.hpp>
 
+#include <OpenCLMocker/DeviceClock.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
 #include <OpenCLMocker/Retainable.hpp>
 #include <OpenCLMocker/TypeValidation.hpp>
 
 #include <CL/cl.h>
 
-#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <vector>
-#include <thread>
 
 namespace OpenCL
 {
 	class Context;
 	class Queue;
 
-	class Event : public Object, public Retainable, private EventValidation
+	class Event : public Object, public Retainable
 	{
 	public:
-		using Clock = std::chrono::high_resolution_clock;
-		using TimePoint = Clock::time_point;
+		using Clock = DeviceClock::Clock;
+		using TimePoint = DeviceClock::TimePoint;
+
+		using CallbackFunction = void (CL_CALLBACK*)(cl_event, cl_int, void*);
 
 		Context* ctx;
+		// nullptr for user events.
 		Queue* queue;
 
-		Event(const TimePoint& start, const TimePoint& end)
-			: queued(Clock::now())
-			, start(start)
-			, end(end)
-		{
-		}
-
-		~Event();
-
-		template <class TDuration>
-		Event(const std::vector<cl_event>& events, const TDuration& duration)
-			: queued(Clock::now())
-			, start(ProduceStart(events))
-			, end(start + duration)
-		{
-		}
-
-		DefaultMove(Event);
+		Event(Queue& queue, cl_command_type type, const DeviceClock::Duration& duration);
+		// User event, it is submitted until the application sets its status.
+		explicit Event(Context& context);
 
-		auto GetDuration() const { return end - start; }
-		bool IsFinished() const { return Clock::now() > end; }
+		cl_command_type GetType() const { return type; }
+		cl_int GetStatus() const { return status; }
+		auto GetDuration() const { return duration; }
+		bool IsFinished() const { return status <= CL_COMPLETE; }
+		bool IsUser() const { return queue == nullptr; }
 		const TimePoint& GetQueued() const { return queued; }
-		const TimePoint& GetSubmitted() const { return start; }
+		const TimePoint& GetSubmitted() const { return submitted; }
 		const TimePoint& GetStart() const { return start; }
 		const TimePoint& GetEnd() const { return end; }
 		const TimePoint& GetComplete() const { return end; }
 
-		void Wait() const
-		{
-			const auto now = Clock::now();
-			if (Validate(this) && end > now)
-				std::this_thread::sleep_for(end - now);
-		}
-
-		static bool Validate(const Event* event) { return event != nullptr && event->Object::Validate() && event->EventValidation::Validate(); }
+		// Waits for the command to be executed without moving the device clock.
+		void WaitForCompletion() const;
+		// Waits for the command and for the device clock to reach its end.
+		void Wait() const;
+		// Waits for all the commands at once: flushes their queues first and moves each device clock only to the latest end.
+		static void WaitForAll(const std::vector<const Event*>& events);
+		// Registers a function to call once the command completes.
+		// Returns false without registering it when the command is already complete.
+		bool AddCompletionHook(std::function<void()> hook);
+		// Posts the callback to the callback dispatcher once the command reaches the status, right away if it already did.
+		void AddCallback(cl_int callbackType, CallbackFunction function, void* userData);
+
+		void Submit(const TimePoint& time);
+		void Run(const TimePoint& time);
+		void Complete(cl_int result = CL_COMPLETE);
+		void SetUserStatus(cl_int result);
+
+		static bool Validate(const Event* event) { return event != nullptr; }
 
 	private:
+		struct Callback
+		{
+			cl_int type;
+			CallbackFunction function;
+			void* userData;
+		};
+
+		DeviceClock* clock;
+		cl_command_type type;
+		DeviceClock::Duration duration;
+		std::atomic<std::int32_t> status = CL_QUEUED;
 		TimePoint queued;
+		TimePoint submitted;
 		TimePoint start;
 		TimePoint end;
 
-		static TimePoint ProduceStart(const std::vector<cl_event>& events)
-		{
-			auto start = Event::Clock::now();
-
-			for (const auto rawOther : events)
-			{
-				const auto& other = *reinterpret_cast<Event*>(rawOther);
-				if (start > other.GetEnd())
-					start = other.GetEnd();
-			}
+		// Guards the hooks and callbacks, waiting for completion only waits on the status.
+		mutable std::mutex mutex;
+		std::vector<std::function<void()>> completionHooks;
+		std::vector<Callback> callbacks;
+		// Lets status changes skip the lock while no callback is registered.
+		std::atomic<bool> hasCallbacks = false;
 
-			return start;
-		}
+		void DispatchCallbacks();
 	};
 }
 
-MapToCl(OpenCL::Event, cl_event)
+MapToCl(OpenCL::Event, cl_event, Event)
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace OpenCL
+{
+	class Object;
+
+	enum class HandleType : std::uint8_t
+	{
+		Context = 1,
+		Queue,
+		Buffer,
+		Program,
+		Kernel,
+		Event,
+	};
+
+	// Value of a cl_* handle: type in the top byte, slot generation below it and slot index + 1
+	// in the low half, so that no handle is null.
+	using Handle = std::uintptr_t;
+
+	static_assert(sizeof(Handle) == sizeof(std::uint64_t), "Handles need 64 bit pointers.");
+
+	// Owner of all objects behind cl_* handles. Slots live in slabs which are never freed and every
+	// release bumps the generation of the slot, so stale, foreign and mistyped handles fail the
+	// lookup instead of being dereferenced.
+	class HandleTable
+	{
+	public:
+		// Takes ownership of the object, its reference count starts at 1.
+		static Handle Add(std::unique_ptr<Object> object, HandleType type);
+
+		// Returns nullptr unless the handle names a live object of the type.
+		static Object* Find(Handle handle, HandleType type)
+		{
+			const auto slot = GetSlot(handle);
+
+			if (slot == nullptr || slot->handle.load(std::memory_order_acquire) != handle || GetType(handle) != type)
+				return nullptr;
+
+			return slot->object;
+		}
+
+		static void Retain(Handle handle);
+		// Destroys the object and frees the slot when the last reference is gone, returns whether it did.
+		static bool Release(Handle handle);
+		static int GetReferenceCount(Handle handle);
+
+	private:
+		static constexpr std::size_t SlabSize = 4096;
+		static constexpr std::size_t MaxSlabs = 4096;
+
+		static constexpr int TypeShift = 56;
+		static constexpr int GenerationShift = 32;
+		static constexpr Handle GenerationMask = (Handle{1} << (TypeShift - GenerationShift)) - 1;
+		static constexpr Handle IndexMask = (Handle{1} << GenerationShift) - 1;
+
+		struct Slot
+		{
+			// Handle of the live object, 0 while the slot is free.
+			std::atomic<Handle> handle = 0;
+			std::atomic<int> useCount = 0;
+			Object* object = nullptr;
+			Handle generation = 0;
+		};
+
+		static inline std::array<std::atomic<Slot*>, MaxSlabs> slabs = {};
+
+		static std::size_t TakeFreeSlot();
+		// Takes up to `count` slots from the shared free list, allocating never used ones when it runs out.
+		static std::vector<std::size_t> TakeSharedSlots(std::vector<std::size_t>& indices, std::size_t& used, std::size_t count);
+
+		static HandleType GetType(Handle handle) { return static_cast<HandleType>(handle >> TypeShift); }
+
+		static Slot* GetSlot(Handle handle)
+		{
+			const auto index = (handle & IndexMask) - 1;
+
+			if (index >= SlabSize * MaxSlabs)
+				return nullptr;
+
+			const auto slab = slabs[index / SlabSize].load(std::memory_order_acquire);
+			return slab != nullptr ? &slab[index % SlabSize] : nullptr;
+		}
+	};
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OpenCL
+{
+	// XXH64 of the data.
+	std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed = 0);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace OpenCL
+{
+	// Immutable text held once per process: handles to equal contents share a single copy from a pool
+	// keyed by content hash, which drops the text when the last handle to it is gone.
+	class InternedText
+	{
+	public:
+		// Empty handle, holds no text.
+		InternedText() = default;
+
+		static InternedText Get(std::string_view text);
+		// Takes over the string when the pool does not hold the text yet.
+		static InternedText Get(std::string&& text);
+
+		std::string_view GetView() const { return entry != nullptr ? std::string_view{entry->text} : std::string_view{}; }
+		const char* GetData() const { return GetView().data(); }
+		std::size_t GetSize() const { return GetView().size(); }
+		// Hash64 of the text.
+		std::uint64_t GetHash() const { return entry != nullptr ? entry->hash : 0; }
+
+		explicit operator bool() const { return entry != nullptr; }
+
+	private:
+		struct Entry
+		{
+			std::string text;
+			std::uint64_t hash;
+		};
+
+		std::shared_ptr<const Entry> entry;
+
+		template <class TText>
+		static InternedText Intern(TText&& text);
+	};
+}
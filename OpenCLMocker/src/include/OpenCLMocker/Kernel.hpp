@@ -3,41 +3,127 @@
 #include <OpenCLMocker/Object.hpp>
 
 #include <OpenCLMocker/MapToCl.hpp>
+#include <OpenCLMocker/Program.hpp>
 #include <OpenCLMocker/Retainable.hpp>
+#include <OpenCLMocker/Retained.hpp>
 #include <OpenCLMocker/TypeValidation.hpp>
 
 #include <CL/cl.h>
 
-#include <map>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace OpenCL
 {
 	class Context;
-	class Program;
 
-	struct KernArg
+	// Argument values of a kernel in a flat array indexed by argument. Values of up to InlineSize bytes, which
+	// covers memory objects and most scalars and vectors, are stored in their slot, larger ones in a single
+	// overflow area. Copying it takes at most two allocations, launches keep a copy as their snapshot.
+	class KernelArgs
 	{
-		std::vector<char> value;
+	public:
+		static constexpr std::size_t InlineSize = 32;
+
+		KernelArgs() = default;
+		explicit KernelArgs(std::size_t count) : slots(count) {}
+
+		std::size_t GetCount() const { return slots.size(); }
+		bool IsSet(std::size_t index) const { return slots[index].isSet; }
+		// Whether none of the arguments below the count is missing.
+		bool IsComplete() const { return setCount == slots.size(); }
+		bool IsLocal(std::size_t index) const { return slots[index].isLocal; }
+		// Bytes of the value, or of the memory of a __local argument.
+		std::size_t GetSize(std::size_t index) const { return slots[index].size; }
+		// Null for __local arguments.
+		const void* GetValue(std::size_t index) const;
+
+		// Indices past the count grow it. Defined here so that clSetKernelArg inlines the common case.
+		void Set(std::size_t index, std::size_t size, const void* value)
+		{
+			auto& slot = Prepare(index);
+			std::memcpy(size <= InlineSize ? slot.value.data() : Reserve(slot, size), value, size);
+			slot.size = size;
+			slot.isLocal = false;
+		}
+
+		void SetLocal(std::size_t index, std::size_t size)
+		{
+			auto& slot = Prepare(index);
+			slot.size = size;
+			slot.isLocal = true;
+		}
+
+	private:
+		struct Slot
+		{
+			std::size_t size = 0;
+			// Units of the overflow area the value uses when it does not fit in place.
+			std::size_t offset = 0;
+			std::size_t capacity = 0;
+			bool isSet = false;
+			bool isLocal = false;
+			alignas(std::max_align_t) std::array<char, InlineSize> value;
+		};
+
+		std::vector<Slot> slots;
+		// Whole units keep the values aligned. Space of values which outgrew it is only reclaimed by a copy.
+		std::vector<std::max_align_t> overflow;
+		std::size_t setCount = 0;
+
+		Slot& Prepare(std::size_t index)
+		{
+			if (index >= slots.size())
+				slots.resize(index + 1);
+
+			auto& slot = slots[index];
+
+			if (!slot.isSet)
+			{
+				slot.isSet = true;
+				++setCount;
+			}
+
+			return slot;
+		}
+
+		// Overflow space for a value of the size.
+		void* Reserve(Slot& slot, std::size_t size);
 	};
 
-	class Kernel : public Object, public Retainable, private KernelValidation
+	class Kernel : public Object, public Retainable
 	{
 	public:
+		// Highest argument count of kernels without a declaration, the smallest CL_DEVICE_MAX_PARAMETER_SIZE
+		// allows no more.
+		static constexpr cl_uint MaxUndeclaredArgs = 1024;
+
 		Context* ctx;
-		Program* program;
+		// Kernels keep their program alive.
+		Retained<Program> program;
 		std::string name;
+		// Declaration found in the program source. Arguments are only validated when it is known.
+		std::shared_ptr<const KernelSignature> signature;
 
-		Kernel() = default;
+		// Arguments are sized from the signature when there is one.
+		explicit Kernel(std::shared_ptr<const KernelSignature> signature);
+		~Kernel();
 
-		static bool Validate(const Kernel* kernel) { return kernel != nullptr && kernel->Object::Validate() && kernel->KernelValidation::Validate(); }
+		static bool Validate(const Kernel* kernel) { return kernel != nullptr; }
 
-		void SetArg(cl_uint index, size_t size, const void* value);
+		// Returns the status instead of throwing, it is on the hot path of every launch.
+		cl_int SetArg(cl_uint index, size_t size, const void* value);
+		// What was wrong with the arguments of a SetArg call which returned the status, only built on failure.
+		std::string DescribeArgError(cl_int status, cl_uint index, size_t size, const void* value) const;
+		const KernelArgs& GetArgs() const { return args; }
 
 	private:
-		std::map<size_t, KernArg> args;
+		KernelArgs args;
 	};
 }
 
-MapToCl(OpenCL::Kernel, cl_kernel)
+MapToCl(OpenCL::Kernel, cl_kernel, Kernel)
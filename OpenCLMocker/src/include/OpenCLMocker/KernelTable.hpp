@@ -0,0 +1,57 @@
+#pragma once
+
+#include <OpenCLMocker/InternedText.hpp>
+
+#include <CL/cl.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace OpenCL
+{
+	struct KernelArgSignature
+	{
+		std::string name;
+		// Without qualifiers, as CL_KERNEL_ARG_TYPE_NAME reports it. Pointers end with '*'.
+		std::string typeName;
+		cl_kernel_arg_address_qualifier addressQualifier = CL_KERNEL_ARG_ADDRESS_PRIVATE;
+		cl_kernel_arg_access_qualifier accessQualifier = CL_KERNEL_ARG_ACCESS_NONE;
+		cl_kernel_arg_type_qualifier typeQualifier = CL_KERNEL_ARG_TYPE_NONE;
+		bool isPointer = false;
+		// Bytes clSetKernelArg expects, 0 when any size is accepted.
+		std::size_t size = 0;
+
+		bool IsLocal() const { return isPointer && addressQualifier == CL_KERNEL_ARG_ADDRESS_LOCAL; }
+	};
+
+	struct KernelSignature
+	{
+		std::string name;
+		std::vector<KernelArgSignature> args;
+	};
+
+	// Kernels declared by an OpenCL C source. The source is scanned once, following comments, conditional
+	// blocks and macros, including the ones defined with -D in the build options. Types the scanner does
+	// not know, such as structs, get no size, so their arguments are not validated.
+	class KernelTable
+	{
+	public:
+		std::vector<KernelSignature> kernels;
+
+		// Tables are shared by all programs built from the same source with the same options.
+		static std::shared_ptr<const KernelTable> Get(const InternedText& source, const std::string& options);
+
+		const KernelSignature* Find(const std::string& name) const;
+		// Kernel names separated by ';'.
+		std::string GetNames() const;
+
+	private:
+		std::unordered_map<std::string, std::size_t> indices;
+
+		static KernelTable Scan(std::string_view source, const std::string& options);
+	};
+}
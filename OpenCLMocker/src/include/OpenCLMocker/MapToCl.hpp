@@ -1,44 +1,22 @@
 #pragma once
 
+#include <OpenCLMocker/HandleTable.hpp>
 #include <OpenCLMocker/Object.hpp>
 
-#include <atomic>
-#include <cstdint>
 #include <memory>
 
-namespace OpenCL
-{
-	struct ObjectHandle
-	{
-		std::unique_ptr<Object> ptr;
-		std::atomic<int> useCount = 1;
-
-		inline ObjectHandle(std::unique_ptr<Object> ptr_)
-			: ptr(std::move(ptr_))
-		{
-		}
-	};
-}
-
-#define MapToCl(TFrom, TTo) \
-	inline OpenCL::ObjectHandle& MapHandle(TTo ptr) { return *reinterpret_cast<OpenCL::ObjectHandle*>(ptr); } \
-	inline OpenCL::ObjectHandle*& MapHandle(TTo* ptr) { return *reinterpret_cast<OpenCL::ObjectHandle**>(ptr); } \
-	inline TFrom& MapType(TTo ptr) { return *static_cast<TFrom*>(reinterpret_cast<OpenCL::ObjectHandle*>(ptr)->ptr.get()); } \
+// MapType returns nullptr for handles which are not live objects of the type.
+#define MapToCl(TFrom, TTo, THandleType) \
+	inline TFrom* MapType(TTo handle) { return static_cast<TFrom*>(OpenCL::HandleTable::Find(reinterpret_cast<OpenCL::Handle>(handle), OpenCL::HandleType::THandleType)); } \
+	inline TTo MapType(const TFrom& ref) { return reinterpret_cast<TTo>(ref.handle); } \
+	inline TTo MapType(const TFrom* ref) { return ref != nullptr ? MapType(*ref) : nullptr; } \
 	inline TTo MakeHandle(std::unique_ptr<TFrom> ptr) \
 	{ \
-		auto weakPtr = ptr.get();\
-		weakPtr->handle = new OpenCL::ObjectHandle{std::move(ptr)}; \
+		auto weakPtr = ptr.get(); \
+		weakPtr->handle = OpenCL::HandleTable::Add(std::move(ptr), OpenCL::HandleType::THandleType); \
 		return reinterpret_cast<TTo>(weakPtr->handle); \
 	} \
-	inline TTo MakeHandle(TFrom ref) \
-	{ \
-		return MakeHandle(std::make_unique<TFrom>(std::move(ref))); \
-	} \
-	inline TTo MakeHandle(TFrom* ref) \
-	{ \
-		ref->handle = new OpenCL::ObjectHandle{std::unique_ptr<TFrom>{ref}}; \
-		return reinterpret_cast<TTo>(ref->handle); \
-	}
+	inline TTo MakeHandle(TFrom* ref) { return MakeHandle(std::unique_ptr<TFrom>{ref}); }
 
 #define DirectMapToCl(TFrom, TTo) \
 	inline TFrom& MapType(TTo ptr) { return *reinterpret_cast<TFrom*>(ptr); } \
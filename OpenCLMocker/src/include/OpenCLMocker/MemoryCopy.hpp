@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace OpenCL
+{
+	// Width in bytes, height in rows and depth in slices.
+	using Region = std::array<std::size_t, 3>;
+
+	// Position of a region inside linear memory, origin[0] and the pitches are in bytes.
+	struct RectLayout
+	{
+		Region origin;
+		std::size_t rowPitch;
+		std::size_t slicePitch;
+
+		std::size_t GetOffset() const { return origin[2] * slicePitch + origin[1] * rowPitch + origin[0]; }
+		// Offset one past the last byte of the region.
+		std::size_t GetEnd(const Region& region) const { return GetOffset() + (region[2] - 1) * slicePitch + (region[1] - 1) * rowPitch + region[0]; }
+	};
+
+	// Transfers from Config::parallelCopyThreshold bytes on are split into chunks over the thread pool,
+	// the calling thread takes part and returns once all chunks are copied.
+	void CopyBytes(void* dst, const void* src, std::size_t size);
+
+	// Repeats the pattern over the memory, size has to be a multiple of patternSize.
+	void FillPattern(void* dst, std::size_t size, const void* pattern, std::size_t patternSize);
+
+	// Copies the region row by row, merging rows and slices that are contiguous on both sides into single copies.
+	void CopyRect(char* dst, const RectLayout& dstLayout, const char* src, const RectLayout& srcLayout, const Region& region);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <OpenCLMocker/DeviceMemory.hpp>
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace OpenCL
+{
+	// Caches storage of released buffers by size class, so buffers of similar sizes reuse it.
+	class MemoryPool
+	{
+		ForbidCopy(MemoryPool);
+		ForbidMove(MemoryPool);
+
+	public:
+		struct Statistics
+		{
+			std::size_t hits;
+			std::size_t misses;
+			std::size_t cachedBytes;
+			std::size_t cachedBlocks;
+		};
+
+		// Uses the bufferPoolLimit setting.
+		MemoryPool();
+		// Bytes of released storage kept for reuse, 0 disables caching.
+		explicit MemoryPool(std::size_t limit);
+
+		// Storage of at least `size` bytes, its contents are undefined.
+		DeviceMemory Acquire(std::size_t size);
+		void Recycle(DeviceMemory memory);
+
+		Statistics GetStatistics() const;
+
+	private:
+		static constexpr std::size_t MinClassSize = 256;
+		static constexpr std::size_t StepsPerDoubling = 4;
+		static constexpr std::size_t ClassCount = (64 - 8) * StepsPerDoubling + 1;
+
+		struct SizeClass
+		{
+			std::mutex mutex;
+			std::vector<DeviceMemory> blocks;
+		};
+
+		std::size_t limit;
+		std::array<SizeClass, ClassCount> classes;
+		std::atomic<std::size_t> hits = 0;
+		std::atomic<std::size_t> misses = 0;
+		std::atomic<std::size_t> cachedBytes = 0;
+		std::atomic<std::size_t> cachedBlocks = 0;
+
+		// Returns the class index and rounds the size up to the class size.
+		static std::size_t GetSizeClass(std::size_t& size);
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <atomic>
+
+namespace OpenCL
+{
+	// Intrusive multi-producer single-consumer queue. Push is wait-free, producers only exchange the
+	// tail and link the previous node. TNode needs a default constructor and a `std::atomic<TNode*> next`.
+	template <class TNode>
+	class MpscQueue
+	{
+		ForbidCopy(MpscQueue);
+		ForbidMove(MpscQueue);
+
+	public:
+		MpscQueue()
+			: head(&stub)
+			, tail(&stub)
+		{
+		}
+
+		void Push(TNode* node)
+		{
+			node->next.store(nullptr, std::memory_order_relaxed);
+			const auto previous = tail.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		// Consumer only. Returns nullptr when the queue is empty or the oldest node is not linked in yet.
+		TNode* Pop()
+		{
+			auto first = head;
+			auto next = first->next.load(std::memory_order_acquire);
+
+			if (first == &stub)
+			{
+				if (next == nullptr)
+					return nullptr;
+
+				head = next;
+				first = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+
+			if (next != nullptr)
+			{
+				head = next;
+				return first;
+			}
+
+			if (first != tail.load(std::memory_order_acquire))
+				return nullptr;
+
+			// The last node can only be taken once another one follows it.
+			Push(&stub);
+			next = first->next.load(std::memory_order_acquire);
+
+			if (next == nullptr)
+				return nullptr;
+
+			head = next;
+			return first;
+		}
+
+	private:
+		TNode stub;
+		TNode* head;
+		std::atomic<TNode*> tail;
+	};
+}
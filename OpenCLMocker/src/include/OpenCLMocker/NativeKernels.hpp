@@ -0,0 +1,41 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <OpenCLMocker/NativeKernel.hpp>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenCL
+{
+	class Kernel;
+
+	// Kernel implementations registered by the plugins from the config.
+	class NativeKernels : public Native::KernelRegistry
+	{
+		ForbidCopy(NativeKernels);
+		ForbidMove(NativeKernels);
+
+	public:
+		static NativeKernels& GetInstance();
+
+		Native::KernelFunction Find(const std::string& name) const;
+
+		void Register(const char* name, Native::KernelFunction function) override;
+
+		// Snapshots the kernel arguments and returns the work executing the range on the thread pool.
+		// Returns an empty function for kernels without an implementation.
+		std::function<void()> Prepare(const Kernel& kernel, const std::vector<size_t>& global_work_offset, const std::vector<size_t>& global_work_size, const std::vector<size_t>& local_work_size) const;
+
+	private:
+		std::map<std::string, Native::KernelFunction, std::less<>> kernels;
+
+		NativeKernels();
+		~NativeKernels() = default;
+
+		void Load(const std::string& path);
+	};
+}
@@ -13,6 +13,7 @@ namespace OpenCL
 
 	public:
 		Object() = default;
+		virtual ~Object() = default;
 		DefaultMove(Object);
 
 	protected:
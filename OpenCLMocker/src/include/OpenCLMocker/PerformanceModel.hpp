@@ -0,0 +1,50 @@
+#pragma once
+
+#include <OpenCLMocker/DeviceClock.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenCL
+{
+	class PerformanceConfig;
+
+	enum class TransferDirection
+	{
+		HostToDevice,
+		DeviceToHost,
+		DeviceToDevice,
+	};
+
+	// Computes simulated command durations of a device.
+	class PerformanceModel
+	{
+	public:
+		PerformanceModel();
+		PerformanceModel(const PerformanceConfig& cfg);
+
+		DeviceClock::Duration GetTransferDuration(TransferDirection direction, std::size_t size) const;
+		DeviceClock::Duration GetKernelDuration(const std::string& name, std::size_t globalSize) const;
+		DeviceClock::Duration GetCachedBuildDuration() const;
+
+	private:
+		struct KernelCost
+		{
+			std::size_t globalSize;
+			double overhead;
+			double workItemCost;
+		};
+
+		double hostToDeviceBandwidth;
+		double deviceToHostBandwidth;
+		double deviceToDeviceBandwidth;
+		double copyLatency;
+		double cachedBuildLatency;
+		KernelCost defaultKernelCost;
+		std::map<std::string, std::vector<KernelCost>, std::less<>> kernelCosts;
+
+		const KernelCost& FindKernelCost(const std::string& name, std::size_t globalSize) const;
+	};
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace OpenCL
+{
+	// Free list of fixed size blocks. Every thread keeps a small cache, so allocations only
+	// take the shared lock when the cache runs empty or overflows. Blocks are never given back.
+	template <std::size_t BlockSize>
+	class BlockPool
+	{
+	public:
+		static void* Allocate()
+		{
+			auto& cache = Cache::Get();
+
+			if (cache.blocks.empty())
+				cache.Exchange(0, CacheSize / 2);
+
+			if (cache.blocks.empty())
+				return ::operator new(BlockSize);
+
+			const auto block = cache.blocks.back();
+			cache.blocks.pop_back();
+			return block;
+		}
+
+		static void Free(void* block)
+		{
+			if (cacheDestroyed)
+			{
+				auto& shared = GetShared();
+				auto lock = std::lock_guard{shared.mutex};
+				shared.blocks.push_back(block);
+				return;
+			}
+
+			auto& cache = Cache::Get();
+
+			if (cache.blocks.size() >= CacheSize)
+				cache.Exchange(CacheSize / 2, 0);
+
+			cache.blocks.push_back(block);
+		}
+
+	private:
+		static constexpr std::size_t CacheSize = 64;
+
+		struct Shared
+		{
+			std::mutex mutex;
+			std::vector<void*> blocks;
+		};
+
+		struct Cache
+		{
+			std::vector<void*> blocks;
+
+			static Cache& Get()
+			{
+				thread_local auto cache = Cache{};
+				return cache;
+			}
+
+			// Moves `give` blocks to the shared list, then takes up to `take` from it.
+			void Exchange(std::size_t give, std::size_t take)
+			{
+				auto& shared = GetShared();
+				auto lock = std::lock_guard{shared.mutex};
+
+				shared.blocks.insert(shared.blocks.end(), blocks.end() - give, blocks.end());
+				blocks.resize(blocks.size() - give);
+
+				take = std::min(take, shared.blocks.size());
+				blocks.insert(blocks.end(), shared.blocks.end() - take, shared.blocks.end());
+				shared.blocks.resize(shared.blocks.size() - take);
+			}
+
+			~Cache()
+			{
+				Exchange(blocks.size(), 0);
+				cacheDestroyed = true;
+			}
+		};
+
+		static inline thread_local bool cacheDestroyed = false;
+
+		// Leaked, blocks can be freed by static destructors of other translation units.
+		static Shared& GetShared()
+		{
+			static auto& shared = *new Shared{};
+			return shared;
+		}
+	};
+
+	// Allocates objects of exactly TObject type from a BlockPool.
+	template <class TObject>
+	class Pooled
+	{
+	public:
+		static void* operator new(std::size_t size)
+		{
+			return size == sizeof(TObject) ? BlockPool<sizeof(TObject)>::Allocate() : ::operator new(size);
+		}
+
+		static void operator delete(void* ptr, std::size_t size)
+		{
+			if (size == sizeof(TObject))
+				BlockPool<sizeof(TObject)>::Free(ptr);
+			else
+				::operator delete(ptr);
+		}
+	};
+}
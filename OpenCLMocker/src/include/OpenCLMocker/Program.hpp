@@ -4,15 +4,20 @@
 
 #include <OpenCLMocker/Context.hpp>
 #include <OpenCLMocker/Device.hpp>
+#include <OpenCLMocker/InternedText.hpp>
+#include <OpenCLMocker/KernelTable.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
 #include <OpenCLMocker/Retainable.hpp>
 
 #include <CL/cl.h>
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 namespace OpenCL
 {
-	class Kernel;
-
 	enum class BuildStatus
 	{
 		None,
@@ -21,22 +26,69 @@ namespace OpenCL
 		InProgress,
 	};
 
-	class Program : public Object, public Retainable, private ProgramValidation
+	class Program : public Object, public Retainable
 	{
 	public:
+		// What a build produces, published as a whole when the build finishes.
+		struct Executable
+		{
+			std::vector<InternedText> binaries;
+			// Kernels found in the source.
+			std::shared_ptr<const KernelTable> kernelTable;
+		};
+
 		Context* ctx;
+		// The source strings concatenated, as the compiler sees them. Empty for programs created from binaries.
+		// Set on creation, never changes.
+		InternedText source;
+
+		Program() = default;
+		// Programs created from binaries are associated with the devices of the binaries.
+		Program(std::vector<Device*> devices, std::vector<InternedText> binaries);
+
+		// Checks that the program can be built for the devices, then adopts them if the program has none yet and
+		// marks every device as building, all in one step. Returns the devices the build is for.
+		std::vector<Device*> StartBuild(const std::vector<Device*>& buildDevices, std::string buildOptions);
+		// Produces the binaries for the devices of the program, from the program cache when possible, and the
+		// kernel table. Programs created from binaries keep them. Returns whether no device had to be compiled for.
+		// Only reads the program, the result is published by FinishBuild.
+		bool Compile(Executable& executable) const;
+		void FinishBuild(Executable executable);
+		void FailBuild(const std::string& log);
+
+		// Checks that no build is in progress and the program has an executable, then counts a kernel created
+		// from it in the same step, so that no build starts in between. Returns the kernel table, null for
+		// programs which were created from binaries and never built.
+		std::shared_ptr<const KernelTable> AttachKernel();
+		void DetachKernel();
+
+		// Readers get copies taken under the lock, a build can replace the originals at any time.
+		std::vector<Device*> GetDevices() const;
+		std::vector<InternedText> GetBinaries() const;
+		// Null while the program is being built or before it was built.
+		std::shared_ptr<const KernelTable> GetKernelTable() const;
+		// None and an empty log for devices the program was never built for.
+		BuildStatus GetBuildStatus(std::size_t device) const;
+		std::string GetBuildLog(std::size_t device) const;
+		std::string GetBuildOptions() const;
+		// Whether the program was built with -cl-kernel-arg-info from source.
+		bool HasKernelArgInfo() const;
+
+		static bool Validate(const Program* program) { return program != nullptr; }
+
+	private:
+		// Guards everything below, asynchronous builds write it while other threads query it.
+		mutable std::mutex buildMutex;
 		std::vector<Device*> devices;
-		std::vector<std::string> sources;
-		std::vector<std::vector<char>> binaries;
-		std::vector<Kernel*> kernels;
+		Executable executable;
+		std::string options;
 		std::vector<BuildStatus> buildStatuses;
 		std::vector<std::string> buildLogs;
-		std::string options;
-
-		Program() = default;
+		// Kernels created from the program which are not released yet.
+		std::size_t attachedKernels = 0;
 
-		static bool Validate(const Program* program) { return program != nullptr && program->Object::Validate() && program->ProgramValidation::Validate(); }
+		bool IsBuilding() const;
 	};
 }
 
-MapToCl(OpenCL::Program, cl_program)
+MapToCl(OpenCL::Program, cl_program, Program)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+#include <OpenCLMocker/InternedText.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace OpenCL
+{
+	class Device;
+
+	// Content addressed store of built program binaries, a file per key under Config::programCacheRoot.
+	// Entries are written to a temporary file and renamed, so processes can share the directory.
+	class ProgramCache
+	{
+		ForbidCopy(ProgramCache);
+		ForbidMove(ProgramCache);
+
+	public:
+		static ProgramCache& GetInstance();
+
+		bool IsEnabled() const { return root.has_value(); }
+
+		// Hash of everything the binary depends on: the source, the build options and the device.
+		static std::uint64_t GetKey(const InternedText& source, const std::string& options, const Device& device);
+
+		std::optional<InternedText> Find(std::uint64_t key) const;
+		void Store(std::uint64_t key, const InternedText& binary) const;
+
+	private:
+		std::optional<std::filesystem::path> root;
+
+		ProgramCache(std::optional<std::filesystem::path> root);
+		~ProgramCache() = default;
+
+		std::filesystem::path GetPath(std::uint64_t key) const;
+	};
+}
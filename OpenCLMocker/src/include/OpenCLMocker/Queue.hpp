@@ -6,17 +6,27 @@
 #include <OpenCLMocker/Device.hpp>
 #include <OpenCLMocker/Event.hpp>
 #include <OpenCLMocker/MapToCl.hpp>
+#include <OpenCLMocker/MpscQueue.hpp>
 #include <OpenCLMocker/Retainable.hpp>
+#include <OpenCLMocker/Retained.hpp>
 #include <OpenCLMocker/TypeValidation.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 namespace OpenCL
 {
 	class Kernel;
 
-	class Queue : public Object, public Retainable, private QueueValidation
+	class Queue : public Object, public Retainable
 	{
 	public:
 		Context* ctx = nullptr;
@@ -24,30 +34,85 @@ namespace OpenCL
 		bool outOfOrderExecutionMode = false;
 		bool profilingEnabled = false;
 
-		Queue() = default;
+		Queue(Context* context, Device* device);
+		~Queue();
 
-		void RegisterEvent(Event* ev)
-		{
-			events.emplace_back(ev);
-			ev->queue = this;
-			ev->ctx = ctx;
-		}
-
-		void UnregisterEvent(Event* ev) { events.erase(std::find(events.begin(), events.end(), ev)); }
+		// Adds a command to the queue, it is executed by the queue worker once flushed and once the wait list is complete.
+		Retained<Event> Enqueue(cl_command_type type, const DeviceClock::Duration& duration, const std::vector<cl_event>& event_wait_list, std::function<void()> work, cl_event* ev);
 
-		void Wait() const
-		{
-			for (auto& ev : events)
-				ev->Wait();
-		}
+		// Submits all enqueued commands to the worker, returns the number of commands submitted so far.
+		std::size_t Flush();
+		// Flushes and waits for all enqueued commands to complete.
+		void Wait();
 
-		static bool Validate(const Queue* queue) { return queue != nullptr && queue->Object::Validate() && queue->QueueValidation::Validate(); }
+		static bool Validate(const Queue* queue) { return queue != nullptr; }
 
 		void EnqueueNDRangeKernel(const Kernel& kernel, const std::vector<size_t>& global_work_offset, const std::vector<size_t>& global_work_size, const std::vector<size_t>& local_work_size, const std::vector<cl_event>& event_wait_list, cl_event* ev);
 
 	private:
-		std::vector<Event*> events;
+		struct Command
+		{
+			std::atomic<Command*> next = nullptr;
+			Retained<Event> event;
+			std::vector<Retained<Event>> waitList;
+			std::function<void()> work;
+			// Position in submission order.
+			std::size_t sequence = 0;
+			bool hasWaitList = false;
+			// Wait list events which are not complete yet, plus one while the command is being received.
+			std::size_t blockers = 1;
+			cl_int result = CL_COMPLETE;
+		};
+
+		// Host time of a flush and the number of commands enqueued before it.
+		struct FlushPoint
+		{
+			std::size_t count;
+			Event::TimePoint time;
+		};
+
+		// Enqueued commands in submission order, enqueueing takes no lock.
+		MpscQueue<Command> submitted;
+		std::atomic<std::size_t> enqueuedCount = 0;
+		std::atomic<std::size_t> flushed = 0;
+
+		std::mutex mutex;
+		std::condition_variable hasWork;
+		std::condition_variable drained;
+		std::thread worker;
+		bool stopping = false;
+		// Whether the worker holds a reference, taken by a flush and dropped once every flushed command is complete.
+		// Releasing the queue does not wait for its commands, the worker destroys it when the application released it.
+		bool keepsAlive = false;
+
+		// The first `flushed` commands are visible to the worker, which takes them in order.
+		std::deque<FlushPoint> flushes;
+		std::size_t received = 0;
+		std::size_t completedCount = 0;
+		// Out-of-order queues complete commands in any order: waiting for the queue waits until every command before
+		// the flushed one is complete, the length of that prefix is kept along with the completed commands after it.
+		std::size_t completedPrefix = 0;
+		std::set<std::size_t> completedAfterPrefix;
+		std::size_t drainWaiters = 0;
+		Event::TimePoint lastEnd;
+
+		// Implicit dependencies: the previous command for in-order queues, barriers and the commands since the last barrier for out-of-order ones.
+		Retained<Event> lastEvent;
+		Retained<Event> lastBarrier;
+		std::vector<Retained<Event>> sinceBarrier;
+		std::size_t sinceBarrierPruneSize = 64;
+
+		// Commands with all dependencies complete and commands waiting for their simulated end.
+		std::deque<std::unique_ptr<Command>> ready;
+		std::multimap<Event::TimePoint, std::unique_ptr<Command>> running;
+
+		void AddImplicitDependencies(Command& command);
+		Command* TakeSubmitted();
+		void Process();
+		void Receive(std::unique_ptr<Command> command);
+		void Unblock(Command* command);
+		Event::TimePoint Start(Command& command);
 	};
 }
 
-MapToCl(OpenCL::Queue, cl_command_queue)
+MapToCl(OpenCL::Queue, cl_command_queue, Queue)
@@ -1,18 +1,19 @@
 #pragma once
 
+#include <OpenCLMocker/HandleTable.hpp>
+
 namespace OpenCL
 {
-	struct ObjectHandle;
-
 	class Retainable
 	{
 	public:
-		ObjectHandle* handle = nullptr;
+		Handle handle = 0;
 
 		Retainable() = default;
 
-		void Retain(ObjectHandle& handle);
-		bool Release(ObjectHandle& handle);
-		int GetReferenceCount(ObjectHandle& handle) const;
+		void Retain();
+		// Destroys the object when the last reference is gone, returns whether it did.
+		bool Release();
+		int GetReferenceCount() const;
 	};
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <utility>
+
+namespace OpenCL
+{
+	// Owning reference to a retainable object, releases the object when the last reference is gone.
+	template <class TObject>
+	class Retained
+	{
+	public:
+		Retained() = default;
+
+		explicit Retained(TObject& object)
+			: object(&object)
+		{
+			object.Retain();
+		}
+
+		Retained(const Retained& other)
+			: object(other.object)
+		{
+			if (object != nullptr)
+				object->Retain();
+		}
+
+		Retained(Retained&& other) noexcept
+			: object(std::exchange(other.object, nullptr))
+		{
+		}
+
+		~Retained() { Reset(); }
+
+		Retained& operator=(Retained other)
+		{
+			std::swap(object, other.object);
+			return *this;
+		}
+
+		// Takes over a reference the caller already owns.
+		static Retained Adopt(TObject& object)
+		{
+			auto ret = Retained{};
+			ret.object = &object;
+			return ret;
+		}
+
+		void Reset()
+		{
+			if (object != nullptr)
+				object->Release();
+			object = nullptr;
+		}
+
+		TObject* Get() const { return object; }
+		TObject& operator*() const { return *object; }
+		TObject* operator->() const { return object; }
+		explicit operator bool() const { return object != nullptr; }
+
+	private:
+		TObject* object = nullptr;
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <OpenCLMocker/ForbidCopy.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OpenCL
+{
+	// Work-stealing pool: every worker owns a deque, takes its own tasks from the back and steals
+	// from the front of the others when it runs out of them.
+	class ThreadPool
+	{
+		ForbidCopy(ThreadPool);
+		ForbidMove(ThreadPool);
+
+	public:
+		using Task = std::function<void()>;
+
+		// 0 threads means one per hardware thread.
+		explicit ThreadPool(std::size_t threads = 0);
+		~ThreadPool();
+
+		static ThreadPool& GetInstance();
+
+		std::size_t GetThreadCount() const { return threads.size(); }
+
+		void Submit(Task task);
+
+		// Runs body(begin, end) over chunks of [0, count) and waits for all of them.
+		// The calling thread takes part in the work, so it is safe to call from a pool thread.
+		void ParallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body);
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+		std::vector<std::thread> threads;
+		std::atomic<std::size_t> nextQueue = 0;
+
+		std::mutex sleepMutex;
+		std::condition_variable hasWork;
+		std::atomic<std::ptrdiff_t> pending = 0;
+		bool stopping = false;
+
+		void Process(std::size_t index);
+		bool RunOne(std::size_t index);
+	};
+}
@@ -1,14 +1,284 @@
 #include <CL/cl.h>
 
-#include <cassert>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <memory>
 #include <string>
+#include <thread>
 
-void Validate(cl_int status)
+// Failed checks are counted instead of asserted, so that release builds check them too.
+int failureCount = 0;
+
+void ReportFailure(const char* expression, const char* file, int line, const std::string& detail)
+{
+	std::cerr << file << ":" << line << ": check failed: " << expression << detail << std::endl;
+	++failureCount;
+}
+
+#define Check(condition) \
+	do { \
+		if (!(condition)) \
+			ReportFailure(#condition, __FILE__, __LINE__, ""); \
+	} while (false)
+
+#define Validate(status) \
+	do { \
+		const auto validated = cl_int{status}; \
+		if (validated != CL_SUCCESS) \
+			ReportFailure(#status, __FILE__, __LINE__, " returned " + std::to_string(validated)); \
+	} while (false)
+
+cl_kernel BuildKernel(cl_context ctx, cl_device_id device, const char* source, const char* name)
+{
+	auto status = cl_int{};
+	auto program = clCreateProgramWithSource(ctx, 1, &source, nullptr, &status);
+	Validate(status);
+	Validate(clBuildProgram(program, 1, &device, "", nullptr, nullptr));
+
+	auto kernel = clCreateKernel(program, name, &status);
+	Validate(status);
+	Validate(clReleaseProgram(program));
+	return kernel;
+}
+
+cl_uint GetArgCount(cl_kernel kernel)
+{
+	auto count = cl_uint{};
+	Validate(clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(count), &count, nullptr));
+	return count;
+}
+
+void TestKernelDeclarations(cl_context ctx, cl_device_id device)
+{
+	// A line continuation with a lone CR and one at the very end of the source.
+	auto kernel = BuildKernel(ctx, device, "kernel void first(int a,\\\r int b) {}\n#define LAST \\\r", "first");
+	Check(GetArgCount(kernel) == 2);
+	Validate(clReleaseKernel(kernel));
+
+	// All the variadic arguments are substituted, and __VA_ARGS__ may be empty.
+	kernel = BuildKernel(ctx, device,
+		"#define DECLARE(name, ...) kernel void name(__VA_ARGS__) {}\n"
+		"DECLARE(second, global float* a, int b, float c)\n"
+		"DECLARE(third)\n", "second");
+	Check(GetArgCount(kernel) == 3);
+	const auto value = 1.0f;
+	Validate(clSetKernelArg(kernel, 2, sizeof(value), &value));
+	Validate(clReleaseKernel(kernel));
+
+	kernel = BuildKernel(ctx, device, "#define DECLARE(name, ...) kernel void name(__VA_ARGS__) {}\nDECLARE(third)\n", "third");
+	Check(GetArgCount(kernel) == 0);
+	Validate(clReleaseKernel(kernel));
+
+	// Overflowing #if arithmetic wraps around instead of trapping.
+	kernel = BuildKernel(ctx, device,
+		"#if (-9223372036854775807-1) / -1 < 0 && (-9223372036854775807-1) % -1 == 0 && 9223372036854775807 + 1 < 0 && -(-9223372036854775807-1) < 0\n"
+		"kernel void fourth(int a) {}\n"
+		"#else\n"
+		"kernel void fourth(int a, int b) {}\n"
+		"#endif\n", "fourth");
+	Check(GetArgCount(kernel) == 1);
+	Validate(clReleaseKernel(kernel));
+}
+
+void TestSubBufferOutlivesParent(cl_context ctx, cl_device_id device)
+{
+	auto status = cl_int{};
+	auto queue = clCreateCommandQueueWithProperties(ctx, device, nullptr, &status);
+	Validate(status);
+
+	const auto size = std::size_t{4096};
+	auto pattern = std::vector<char>(size, 1);
+	auto parent = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, size, pattern.data(), &status);
+	Validate(status);
+
+	const auto region = cl_buffer_region{size / 2, size / 2};
+	auto subBuffer = clCreateSubBuffer(parent, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &status);
+	Validate(status);
+
+	// The storage of the parent must not be recycled for a new buffer while the sub-buffer uses it.
+	Validate(clReleaseMemObject(parent));
+
+	auto other = clCreateBuffer(ctx, CL_MEM_READ_WRITE, size, nullptr, &status);
+	Validate(status);
+	const auto zero = char{0};
+	Validate(clEnqueueFillBuffer(queue, other, &zero, sizeof(zero), 0, size, 0, nullptr, nullptr));
+
+	auto contents = std::vector<char>(region.size);
+	Validate(clEnqueueReadBuffer(queue, subBuffer, CL_TRUE, 0, region.size, contents.data(), 0, nullptr, nullptr));
+	Check(contents == std::vector<char>(region.size, 1));
+
+	Validate(clReleaseMemObject(other));
+	Validate(clReleaseMemObject(subBuffer));
+	Validate(clReleaseCommandQueue(queue));
+}
+
+cl_command_queue CreateQueue(cl_context ctx, cl_device_id device, cl_command_queue_properties properties)
+{
+	const cl_queue_properties queueProperties[] = {CL_QUEUE_PROPERTIES, properties, 0};
+	auto status = cl_int{};
+	auto queue = clCreateCommandQueueWithProperties(ctx, device, queueProperties, &status);
+	Validate(status);
+	return queue;
+}
+
+cl_mem CreateBuffer(cl_context ctx, std::vector<unsigned char>& contents)
+{
+	auto status = cl_int{};
+	auto buffer = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, contents.size(), contents.data(), &status);
+	Validate(status);
+	return buffer;
+}
+
+// Bytes which differ between neighbours, so that misplaced copies are noticed.
+std::vector<unsigned char> MakeSequence(std::size_t size)
+{
+	auto bytes = std::vector<unsigned char>(size);
+
+	for (auto i = std::size_t{0}; i < size; ++i)
+		bytes[i] = static_cast<unsigned char>(i * 31 + i / 251);
+
+	return bytes;
+}
+
+void TestWriteReadRoundTrip(cl_context ctx, cl_device_id device)
+{
+	auto queue = CreateQueue(ctx, device, 0);
+	const auto size = std::size_t{1024 * 1024};
+	auto initial = std::vector<unsigned char>(size, 0);
+	auto buffer = CreateBuffer(ctx, initial);
+
+	const auto offset = std::size_t{4096 + 3};
+	const auto written = MakeSequence(size / 2);
+	Validate(clEnqueueWriteBuffer(queue, buffer, CL_FALSE, offset, written.size(), written.data(), 0, nullptr, nullptr));
+
+	// The non-blocking read is only complete after clFinish.
+	auto contents = std::vector<unsigned char>(size, 0xEE);
+	Validate(clEnqueueReadBuffer(queue, buffer, CL_FALSE, 0, size, contents.data(), 0, nullptr, nullptr));
+	Validate(clFinish(queue));
+
+	auto expected = initial;
+	std::copy(written.begin(), written.end(), expected.begin() + offset);
+	Check(contents == expected);
+
+	Validate(clReleaseMemObject(buffer));
+	Validate(clReleaseCommandQueue(queue));
+}
+
+void TestLargeFill(cl_context ctx, cl_device_id device)
 {
-	assert(status == CL_SUCCESS);
+	auto queue = CreateQueue(ctx, device, 0);
+
+	// Above the default parallel copy threshold, so that the fill is split in chunks, and not aligned to them.
+	const auto patternSize = std::size_t{32};
+	const auto offset = patternSize * 3;
+	const auto fillSize = std::size_t{17 * 1024 * 1024} + patternSize * 5;
+	auto initial = std::vector<unsigned char>(offset + fillSize + patternSize, 0xEE);
+	auto buffer = CreateBuffer(ctx, initial);
+
+	const auto pattern = MakeSequence(patternSize);
+	Validate(clEnqueueFillBuffer(queue, buffer, pattern.data(), pattern.size(), offset, fillSize, 0, nullptr, nullptr));
+
+	auto contents = std::vector<unsigned char>(initial.size());
+	Validate(clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0, contents.size(), contents.data(), 0, nullptr, nullptr));
+
+	auto expected = initial;
+	for (auto i = std::size_t{0}; i < fillSize; ++i)
+		expected[offset + i] = pattern[i % patternSize];
+	Check(contents == expected);
+
+	Validate(clReleaseMemObject(buffer));
+	Validate(clReleaseCommandQueue(queue));
+}
+
+void TestReadRect(cl_context ctx, cl_device_id device)
+{
+	auto queue = CreateQueue(ctx, device, 0);
+
+	const auto bufferPitch = std::size_t{64};
+	auto initial = MakeSequence(bufferPitch * 8);
+	auto buffer = CreateBuffer(ctx, initial);
+
+	const size_t bufferOrigin[] = {8, 2, 0};
+	const size_t hostOrigin[] = {4, 1, 0};
+	const size_t region[] = {16, 4, 1};
+	const auto hostPitch = std::size_t{24};
+	auto contents = std::vector<unsigned char>(hostPitch * 6, 0xEE);
+	Validate(clEnqueueReadBufferRect(queue, buffer, CL_TRUE, bufferOrigin, hostOrigin, region, bufferPitch, 0, hostPitch, 0, contents.data(), 0, nullptr, nullptr));
+
+	auto expected = std::vector<unsigned char>(contents.size(), 0xEE);
+	for (auto row = std::size_t{0}; row < region[1]; ++row)
+		for (auto x = std::size_t{0}; x < region[0]; ++x)
+			expected[(hostOrigin[1] + row) * hostPitch + hostOrigin[0] + x] = initial[(bufferOrigin[1] + row) * bufferPitch + bufferOrigin[0] + x];
+	Check(contents == expected);
+
+	Validate(clReleaseMemObject(buffer));
+	Validate(clReleaseCommandQueue(queue));
+}
+
+void TestMapWriteUnmapRead(cl_context ctx, cl_device_id device)
+{
+	auto queue = CreateQueue(ctx, device, 0);
+	auto initial = std::vector<unsigned char>(4096, 0);
+	auto buffer = CreateBuffer(ctx, initial);
+
+	const auto offset = std::size_t{256};
+	const auto written = MakeSequence(1024);
+	auto status = cl_int{};
+	auto mapped = static_cast<unsigned char*>(clEnqueueMapBuffer(queue, buffer, CL_TRUE, CL_MAP_WRITE, offset, written.size(), 0, nullptr, nullptr, &status));
+	Validate(status);
+
+	if (mapped != nullptr)
+	{
+		std::copy(written.begin(), written.end(), mapped);
+		Validate(clEnqueueUnmapMemObject(queue, buffer, mapped, 0, nullptr, nullptr));
+	}
+
+	auto contents = std::vector<unsigned char>(written.size());
+	Validate(clEnqueueReadBuffer(queue, buffer, CL_TRUE, offset, contents.size(), contents.data(), 0, nullptr, nullptr));
+	Check(contents == written);
+
+	Validate(clReleaseMemObject(buffer));
+	Validate(clReleaseCommandQueue(queue));
+}
+
+void TestOutOfOrderBarrier(cl_context ctx, cl_device_id device)
+{
+	auto queue = CreateQueue(ctx, device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+	const auto size = std::size_t{64 * 1024};
+	auto zeros = std::vector<unsigned char>(size, 0);
+	auto source = CreateBuffer(ctx, zeros);
+	auto destination = CreateBuffer(ctx, zeros);
+
+	// The fill is held back until the copy was enqueued, only the barrier keeps the copy behind it.
+	auto status = cl_int{};
+	auto gate = clCreateUserEvent(ctx, &status);
+	Validate(status);
+
+	const auto value = static_cast<unsigned char>(7);
+	Validate(clEnqueueFillBuffer(queue, source, &value, sizeof(value), 0, size, 1, &gate, nullptr));
+	Validate(clEnqueueBarrierWithWaitList(queue, 0, nullptr, nullptr));
+
+	auto copied = cl_event{};
+	Validate(clEnqueueCopyBuffer(queue, source, destination, 0, 0, size, 0, nullptr, &copied));
+	Validate(clFlush(queue));
+
+	// Once the queue took the copy, it would run before the fill if nothing ordered them.
+	auto copyStatus = cl_int{CL_QUEUED};
+	while (copyStatus == CL_QUEUED && clGetEventInfo(copied, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(copyStatus), &copyStatus, nullptr) == CL_SUCCESS)
+		std::this_thread::yield();
+
+	Validate(clSetUserEventStatus(gate, CL_COMPLETE));
+
+	auto contents = std::vector<unsigned char>(size);
+	Validate(clEnqueueReadBuffer(queue, destination, CL_TRUE, 0, size, contents.data(), 1, &copied, nullptr));
+	Check(contents == std::vector<unsigned char>(size, value));
+
+	Validate(clReleaseEvent(copied));
+	Validate(clReleaseEvent(gate));
+	Validate(clReleaseMemObject(destination));
+	Validate(clReleaseMemObject(source));
+	Validate(clReleaseCommandQueue(queue));
 }
 
 int main()
@@ -48,6 +318,21 @@ int main()
 			CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(platform), 0};
 		auto ctx = clCreateContextFromType(cps, CL_DEVICE_TYPE_GPU, nullptr, nullptr, &status);
 		Validate(status);
+
+		if (!devices.empty())
+		{
+			TestKernelDeclarations(ctx, devices.front());
+			TestSubBufferOutlivesParent(ctx, devices.front());
+			TestWriteReadRoundTrip(ctx, devices.front());
+			TestLargeFill(ctx, devices.front());
+			TestReadRect(ctx, devices.front());
+			TestMapWriteUnmapRead(ctx, devices.front());
+			TestOutOfOrderBarrier(ctx, devices.front());
+		}
 	}
-	return 0;
+
+	if (failureCount != 0)
+		std::cerr << failureCount << " checks failed." << std::endl;
+
+	return failureCount != 0 ? 1 : 0;
 }